@@ -1,858 +1,6747 @@
-/*******************************************************************************************
-*
-*   raylib [core] example - Basic window
-*
-*   Welcome to raylib!
-*
-*   To test examples, just press F6 and execute raylib_compile_execute script
-*   Note that compiled executable is placed in the same folder as .c file
-*
-*   You can find all basic examples on C:\raylib\raylib\examples folder or
-*   raylib official webpage: www.raylib.com
-*
-*   Enjoy using raylib. :)
-*
-*   Example originally created with raylib 1.0, last time updated with raylib 1.0
-*
-*   Example licensed under an unmodified zlib/libpng license, which is an OSI-certified,
-*   BSD-like license that allows static linking with closed source software
-*
-*   Copyright (c) 2013-2023 Ramon Santamaria (@raysan5)
-*
-********************************************************************************************/
-
-#include "raylib.h"
-#include <stdio.h>
-#include <string.h>
-#include <math.h>
-#include <stdlib.h>
-//------------------------------------------------------------------------------------
-// * utility functions *
-//------------------------------------------------------------------------------------
-bool checkBoxCollisions(int x1, int y1, int w1, int h1, int x2, int y2, int w2, int h2){
-    return x1 + w1 > x2 &&
-           x1 < x2 + w2 &&
-           y1 + h1 > y2 &&
-           y1 < y2 + h2;
-}
-
-float lerp(float a, float b, float w){
-    return ((a - b) * w) + a;
-}
-
-int min(int a, int b){
-    if (a < b){
-        return a;
-    }
-    return b;
-}
-
-
-//-------------------------------------------------------------------
-// * random vars *
-//-------------------------------------------------------------------
-
-const int screenWidth = 450;
-const int screenHeight = 700;
-const int windowWidth = 1280;
-const int windowHeight = 720;
-const float screenZoom = 2.0f;
-const int inGameWidth = (int)(screenWidth / screenZoom);
-const int inGameHeight = (int)(screenHeight / screenZoom);
-int playerX = 0;
-int playerY = 0;
-int playerLevel = 1;
-float backgroundSpeed = 0.0f;
-int killedThisLife = 0;
-const float MAX_BACKGROUND_SPEED = 1.5f;
-int movedBackgrounds = 0;
-int currentBackground = 0;
-
-
-
-//------------------------------------------------------------------------------------
-// * Sprite loading *
-//------------------------------------------------------------------------------------
-
-
-
-Texture2D lampir;
-Texture2D samuel;
-Texture2D player;
-Texture2D playerLeft;
-Texture2D playerRight;
-Texture2D bullet;
-Texture2D powSprite;
-Texture2D mudBackground;
-Texture2D sandBackground;
-Texture2D grassBackground;
-
-Sound shootPlayerSound;
-Sound enemyHitSound;
-Sound explosionSound;
-Sound enemyShootSound;
-Sound bonusSound;
-Sound gameOverSound;
-Music music;
-
-int playerLives = 3;
-#define EXPLOSION_COUNT 7
-Texture2D explosionSprites[EXPLOSION_COUNT];
-Texture2D enemyBullet;
-RenderTexture2D renderTexture;
-
-void loadSprites(){
-    lampir = LoadTexture("sprites/lampir.png");
-    samuel = LoadTexture("sprites/samuel.png");
-    player = LoadTexture("sprites/player_0.png");
-    playerLeft = LoadTexture("sprites/player_1.png");
-    playerRight = LoadTexture("sprites/player_2.png");
-    bullet = LoadTexture("sprites/bullet.png");
-    powSprite = LoadTexture("sprites/pow.png");
-    explosionSprites[0] = LoadTexture("sprites/sprite_3.png");
-    explosionSprites[1] = LoadTexture("sprites/sprite_4.png");
-    explosionSprites[2] = LoadTexture("sprites/sprite_5.png");
-    explosionSprites[3] = LoadTexture("sprites/sprite_6.png");
-    explosionSprites[4] = LoadTexture("sprites/sprite_0.png");
-    explosionSprites[5] = LoadTexture("sprites/sprite_1.png");
-    explosionSprites[6] = LoadTexture("sprites/sprite_2.png");
-    mudBackground = LoadTexture("sprites/mudBack.png");
-    sandBackground = LoadTexture("sprites/sandBack.png");
-    grassBackground = LoadTexture("sprites/grassBack.png");
-    enemyBullet = LoadTexture("sprites/enemy_bullet.png");
-    
-    // render texture
-    renderTexture = LoadRenderTexture(screenWidth, screenHeight);
-    
-    // sounds
-    shootPlayerSound = LoadSound("sounds/laser.wav");
-    enemyHitSound = LoadSound("");
-    explosionSound = LoadSound("sounds/explosion.wav");
-    enemyShootSound = LoadSound("");
-    bonusSound = LoadSound("sounds/bonus.wav");
-    gameOverSound = LoadSound("sounds/gameOver.wav");
-    music = LoadMusicStream("sounds/hudba.mp3");
-}
-
-void unloadSprites(){
-    UnloadTexture(lampir);
-    UnloadTexture(samuel);
-    UnloadTexture(player);
-    UnloadTexture(playerLeft);
-    UnloadTexture(playerRight);
-    UnloadTexture(bullet);
-    UnloadTexture(powSprite);
-    for (int i = 0; i < EXPLOSION_COUNT; i++){
-        UnloadTexture(explosionSprites[i]);
-    }
-    UnloadTexture(mudBackground);
-    UnloadTexture(grassBackground);
-    UnloadTexture(sandBackground);
-    UnloadTexture(enemyBullet);
-    
-    // sounds
-    UnloadSound(shootPlayerSound);
-    UnloadSound(enemyHitSound);
-    UnloadSound(explosionSound);
-    UnloadSound(enemyShootSound);
-    UnloadSound(bonusSound);
-    UnloadSound(gameOverSound);
-    UnloadMusicStream(music);
-    
-    // render texture
-    UnloadRenderTexture(renderTexture);
-}
-
-
-
-//-------------------------------------------------------------------
-// * objects *
-//-------------------------------------------------------------------
-struct Object{
-    int x;
-    int y;
-    int width;
-    int height;
-    int team;
-    bool exists;
-    int type;
-    int health;
-    int internalTimer;
-    int variable1;
-    int variable2;
-    int variable3;
-    int enemyType;
-    int ai;
-};
-
-struct Object initDefaultObject(){
-    struct Object obj;
-    
-    obj.x = 0;
-    obj.y = 0;
-    obj.width = 0;
-    obj.height = 0;
-    obj.team = 0;
-    obj.exists = true;
-    obj.type = 0;
-    obj.health = 0;
-    obj.internalTimer = 0;
-    obj.variable1 = 0;
-    obj.variable2 = 0;
-    obj.variable3 = 0;
-    obj.enemyType = 0;
-    obj.ai = 0;
-    
-    return obj;
-}
-
-#define MAX_OBJECTS 250
-struct Object objects[MAX_OBJECTS];
-#define TEAM_PLAYER 0
-#define TEAM_ENEMIES 1
-#define TEAM_PARTICLE 2
-
-#define TYPE_BULLET 0
-#define ENEMY_SAMUEL 1
-#define POW_PARTICLE 2
-#define EXPLOSION_PARTICLE 3
-#define ENEMY_LAMPIR 4
-
-void updateObjects(){
-    for (int i = 0; i < MAX_OBJECTS; i++){
-        struct Object* obj = &objects[i];
-        
-        if (obj->exists){
-            switch(obj->type){
-                case TYPE_BULLET:
-                    updateBullet(obj);
-                    break;
-                case ENEMY_SAMUEL:
-                    updateSamuel(obj);
-                    break;
-                case POW_PARTICLE:
-                    updatePow(obj);
-                    break;
-                case EXPLOSION_PARTICLE:
-                    updateExplosion(obj);
-                    break;
-                
-            }
-            
-            
-            // collision
-            for (int j = 0; j < MAX_OBJECTS; j++){
-                struct Object* other = &objects[j];
-                if (i != j && other->exists){
-                    if (checkBoxCollisions(obj->x, obj->y, obj->width, obj->height, other->x, other->y, other->width, other->height)){
-                        switch(obj->type){
-                            case TYPE_BULLET:
-                                bulletCollide(obj, other);
-                                break;
-                        }
-                    }
-                
-                }
-            }
-            
-        }
-    }
-}
-
-int nextObjectIndex = 0;
-void addObject(struct Object obj){
-    int i = 0;
-    while(objects[nextObjectIndex].exists || i > MAX_OBJECTS){
-        nextObjectIndex++;
-        nextObjectIndex %= MAX_OBJECTS;
-        i++;
-    }
-    objects[nextObjectIndex] = obj;
-    
-}
-
-//-------------------------------------------------------------------
-// * explosion *
-//-------------------------------------------------------------------
-void updateExplosion(struct Object* this){
-    this->internalTimer--;
-    Texture2D* spr = &explosionSprites[(int)floor((21 - this->internalTimer) / 3)];
-    this->y += backgroundSpeed / 4;
-
-    if (this->internalTimer == 0){
-        this->exists = false;
-    }
-    Vector2 v;
-    v.x = this->x;
-    v.y = this->y;
-    DrawTextureEx(*spr, v, 0.0f, 0.2f, WHITE);
-    
-}
-
-struct Object initExplosion(int x, int y){
-    struct Object out = initDefaultObject();
-    PlaySound(explosionSound);
-    out.x = x;
-    out.y = y;
-    
-    out.team = TEAM_PARTICLE;
-    out.internalTimer = 21;
-    out.type = EXPLOSION_PARTICLE;
-    
-    return out;
-}
-
-
-//-------------------------------------------------------------------
-// * pow *
-//-------------------------------------------------------------------
-struct Object initPow(int x, int y){
-    struct Object obj = initDefaultObject();
-    
-    obj.x = x;
-    obj.y = y;
-    obj.team = TEAM_PARTICLE;
-    obj.type = POW_PARTICLE;
-    obj.internalTimer = 20;
-    
-    return obj;
-}
-
-void updatePow(struct Object* this){
-    this->internalTimer--;
-    
-    this->y += backgroundSpeed / 4;
-    if (this->internalTimer == 0){
-        this->exists = false;
-    }
-    
-    DrawTexture(powSprite, this->x, this->y, WHITE);
-}
-
-//-------------------------------------------------------------------
-// * bullets *
-//-------------------------------------------------------------------
-void updateBullet(struct Object* this){
-    if (this->team == 0){
-        this->y -= 5;
-    }else {
-        this->y += 3;
-    }
-    
-    
-    if (this->y <= 0){
-        this->exists = false;
-    }
-    
-    // draw
-    if (this->team == TEAM_PLAYER){
-        DrawTexture(bullet, this->x, this->y, WHITE);
-    }else {
-        DrawTexture(enemyBullet, this->x, this->y, WHITE);
-    }
-}
-
-struct Object initBullet(int x, int y, int team){
-    struct Object out = initDefaultObject();
-    
-    out.x = x;
-    out.y = y;
-    out.width = 16;
-    out.height = 16;
-    out.exists = true;
-    out.type = TYPE_BULLET;
-    out.team = team;
-    
-    return out;
-}
-
-void bulletCollide(struct Object* this, struct Object* other){
-    if (other->team == TEAM_ENEMIES && this->team == TEAM_PLAYER && other->type != TYPE_BULLET){
-        this->exists = false;
-        other->health -= 10;
-        addObject(initPow(this->x, this->y - 10));
-        other->variable3 = 5;
-    }
-}
-
-//-------------------------------------------------------------------
-// * enemies *
-//-------------------------------------------------------------------
-
-
-struct Object initEnemy(int x , int enemyType, int aiType, float healthMultiplier){
-    struct Object output = initDefaultObject();
-    
-    output.x = x;
-    output.y = -64;
-    output.type = ENEMY_SAMUEL;
-    output.team = TEAM_ENEMIES;
-    output.exists = true;
-    output.enemyType = enemyType;
-    output.ai = aiType;
-    
-    switch (enemyType){
-        case ENEMY_SAMUEL:
-            output.width = 25;
-            output.height = 40;
-            output.health = (int)(120 * healthMultiplier);
-            break;
-        case ENEMY_LAMPIR:
-            output.width = 30;
-            output.height = 49;
-            output.health = (int)(300 * healthMultiplier);
-            break;
-    }
-    
-    return output;
-}
-
-//-------------------------------------------------------------------
-// * samuel *
-//-------------------------------------------------------------------
-int enemiesKilled = 0;
-
-const int AI_DEFAULT = 0;
-const int AI_DIVE = 1;
-const int AI_SHOOT = 2;
-const int AI_SHOOT_DIVE = 3;
-const int AI_SNIPER = 4;
-void updateSamuel(struct Object* this){
-    bool isLampir = this->enemyType == ENEMY_LAMPIR;
-    
-    
-    // smrt
-    if (this->health <= 0){
-        this->exists = false;
-        if (!isLampir){
-            addObject(initExplosion(this->x, this->y));
-        }else {
-            initBigExplosion(this->x, this->y);
-        }
-        killedEnemy();
-    }else if (this->y > inGameHeight){
-        this->exists = false;
-    }
-    if (this->y < 100 || this->ai != AI_SNIPER){
-        this->y += 1;
-    }
-    
-    if ((this->ai == AI_DIVE || this->ai == AI_SHOOT_DIVE) && this->y > 120){
-        this->y += 2;
-    }
-        
-    if (this->ai == AI_DEFAULT || this->ai == AI_SHOOT || this->ai == AI_SNIPER || this->y < 100){
-        if ((this->y % 80 == 0 && GetRandomValue(0, 9) <= 7) || (this->ai == AI_SNIPER && this->internalTimer % 100 == 0)){
-        if (this->x < playerX - 10 || this->x > playerX + 26){
-            this->variable1 = (this->x < playerX) * 2 - 1;
-        }
-        
-        this->variable2 = 10;
-        
-        }
-
-        if (this->variable1 != 0 && this->y % this->variable2 == 0){
-            this->x += this->variable1;
-            this->variable2 -= this->variable2 > 1;
-        }
-    
-    }
-    this->internalTimer++;
-    if (this->internalTimer % 120 == 0 && (this->ai == AI_SNIPER || this->ai == AI_SHOOT || this->ai == AI_SHOOT_DIVE)){
-        addObject(initBullet(this->x + 6, this->y + 6, TEAM_ENEMIES));
-    }
-    
-    
-    Color c = WHITE;
-    // color
-    if (this->variable3 > 0){
-        c.r = RED.r;//(unsigned char) lerp((float)c.r, (float)RED.r, this->variable3 / 10);
-        c.g = RED.g;
-        c.b = RED.b;
-        
-        this->variable3--;
-    }
-    // draw
-    
-    Texture2D* spr = &samuel;
-    if (isLampir){
-        spr = &lampir;
-    }
-    DrawTexture(*spr, this->x, this->y, c);
-}
-
-
-
-
-//-------------------------------------------------------------------
-// * player *
-//-------------------------------------------------------------------
-struct Player{
-    int x;
-    int y;
-    int fireRate;
-    int fireCooldown;
-    int projectileCount;
-    int invinciblity;
-    int deadTimer;
-};
-
-int playerHealth = 3;
-
-const int BOUNDRY_WIDTH = 10;
-const int BOUNDRY_HEIGHT = 100;
-
-void updatePlayer(struct Player* data){
-    // setup vals
-    
-    bool movingLeft = false;
-    bool movingRight = false;
-    
-    
-    // movement
-    if (data->deadTimer == 0){    
-        if (data->x > BOUNDRY_WIDTH && IsKeyDown(KEY_LEFT)){
-            data->x -= 2;
-            movingLeft = true;
-        }
-        else if (data->x < inGameWidth - BOUNDRY_WIDTH - 16 && IsKeyDown(KEY_RIGHT)){
-            data->x += 2;
-            movingRight = true;
-        }
-        
-        if (data->y < inGameHeight - BOUNDRY_WIDTH - 16 && IsKeyDown(KEY_DOWN)){
-            data->y += 1;
-        }else if (data->y > inGameHeight - BOUNDRY_HEIGHT && IsKeyDown(KEY_UP)){
-            data->y -= 1;
-        }
-    
-        
-        playerX = data->x;
-        playerY = data->y;
-        data->projectileCount = playerLevel;
-        // shooting
-        if (IsKeyDown(KEY_SPACE) && data->fireCooldown == 0){
-            if (data->projectileCount == 1 || data->projectileCount == 3){
-                addObject(initBullet(data->x, data->y, 0));
-            }
-            if (data->projectileCount == 2 || data->projectileCount == 3){
-                addObject(initBullet(data->x - 3, data->y + 2, 0));
-                addObject(initBullet(data->x + 3, data->y + 2, 0));
-                            
-            }
-            
-            data->fireCooldown = data->fireRate;
-            PlaySound(shootPlayerSound);
-        }
-        data->fireCooldown -= data->fireCooldown > 0;
-    }
-    
-    
-    // collisions
-    for (int i = 0; i < MAX_OBJECTS; i++){
-        struct Object* obj = &objects[i];
-        
-        if (data->deadTimer == 0 && obj->exists && checkBoxCollisions(data->x, data->y, 16, 16, obj->x, obj->y, obj->width, obj->height)){
-            switch (obj->team){
-                case TEAM_ENEMIES:
-                    if (data->invinciblity == 0){
-                        data->deadTimer++;
-                        addObject(initExplosion(data->x - 10, data->y - 10));
-                    }
-                    break;
-                    
-            }
-        }
-    }
-    
-    
-    
-    // drawing
-    Texture2D* sprite = &player;
-    if (movingLeft){
-        sprite = &playerLeft;
-    }else if (movingRight){
-        sprite = &playerRight;
-    }
-    data->deadTimer += data->deadTimer != 0;
-    data->invinciblity -= data->invinciblity > 0;
-    if (data->invinciblity % 4 < 2 && data->deadTimer == 0){
-        DrawTexture(*sprite, data->x, data->y, WHITE);
-    }
-    
-}
-
-struct Player initPlayer(){
-    struct Player output;
-    
-    output.y = inGameHeight - 40;
-    output.x = inGameWidth / 2 - 8;
-    output.fireRate = 10;
-    output.fireCooldown = 0;
-    output.projectileCount = 1;
-    output.invinciblity = 180;
-    output.deadTimer = 0;
-    playerLevel = 1;
-    killedThisLife = 0;
-    return output;
-}
-
-//-------------------------------------------------------------------
-// * big explosion *
-//-------------------------------------------------------------------
-int explosionTimer = 0;
-int explosionX = 0;;
-int explosionY = 0;
-void initBigExplosion(int x, int y){
-    explosionTimer = 45;
-    explosionX = x;
-    explosionY = y;
-}
-
-void updateExplosions(){
-    explosionTimer -= explosionTimer > 0;
-    
-    if (explosionTimer % 3 == 1){
-        addObject(initExplosion(GetRandomValue(-10, 10) + explosionX, GetRandomValue(-10, 10) + explosionY));
-    }
-}
-
-//-------------------------------------------------------------------
-// * enemy management *
-//-------------------------------------------------------------------
-int upgradeTimer = 0;
-void upgrade(){
-    upgradeTimer = 60;
-    PlaySound(bonusSound);
-    if (playerLevel < 3){
-        playerLevel++;
-    }else{
-        playerLives++;
-    }
-}
-int enemySpawnTimer = 0;
-
-void updateEnemyManagement(){
-    enemySpawnTimer--;
-    if (enemySpawnTimer <= 0){
-        
-        int enemyType = ENEMY_SAMUEL;
-        if (GetRandomValue(0, 100) < min(enemiesKilled, 90)){
-            enemyType = ENEMY_LAMPIR;
-        }
-        
-        int aiType = GetRandomValue(0, (enemiesKilled > 10) + (enemiesKilled > 30) + (enemiesKilled > 40) + (enemiesKilled > 50) + (enemiesKilled > 60));
-        
-        
-        float healthMultiplier = 1.0f;
-        //healthMultiplier += (sin(enemiesKilled) + 1) * 0.2f;
-        
-        addObject(initEnemy(GetRandomValue(0, inGameWidth - 32), enemyType, aiType, healthMultiplier));
-        enemySpawnTimer = 40 + (sin(enemiesKilled) * 10) + (80 * (enemiesKilled < 20)) + (40 * (enemiesKilled < 60)) + (40 * (enemiesKilled < 120));
-    }
-}   
-
-void killedEnemy(){
-    enemiesKilled++;
-    killedThisLife++;
-    
-    if ((playerLevel == 1 && killedThisLife % 10 == 0) ||
-        (playerLevel == 2 && killedThisLife % 35 == 0) ||
-        (playerLevel >= 3 && killedThisLife % 90 == 0)){
-        upgrade();
-    }
-    
-    if (enemiesKilled % 30 == 0){
-        changeBackground();
-    }
-}
-
-//-------------------------------------------------------------------
-// * reset *
-//-------------------------------------------------------------------
-
-void reset(){
-    enemySpawnTimer = 0;
-    enemiesKilled = 0;
-    playerLives = 3;
-    playerLevel = 1;
-    killedThisLife = 0;
-    currentBackground = 0;
-    movedBackgrounds = 0;
-    backgroundSpeed = 0;
-    
-    for (int i = 0; i < MAX_OBJECTS; i++){
-        objects[i].exists = false;
-    }
-}
-
-void gameOver(){
-    DrawText("KONEC HRY", 50, 200, 20, WHITE);
-    DrawText("STISKNI R PRO RESTART", 50, 300, 1, WHITE);
-    
-    if (IsKeyDown(KEY_R)){
-        reset();
-    }
-}
-
-
-//-------------------------------------------------------------------
-// * hud *
-//-------------------------------------------------------------------
-
-#define ONE 2
-#define SCORE_COUNTER_SIZE 10
-
-void drawHud(){
-    
-    const char* str = "ZIVOTY : ";
-    const char num[ONE];
-    const char scoreCounter[SCORE_COUNTER_SIZE];
-    sprintf(num, "%i", playerLives);
-    sprintf(scoreCounter, "%i00", enemiesKilled);
-    DrawText( str , 5, 30, 1, WHITE);
-    DrawText( num , 60, 30, 1, WHITE);
-    DrawText( scoreCounter , 180, 30, 1, WHITE);
-    
-    upgradeTimer-= upgradeTimer > 0;
-    
-    if (upgradeTimer % 8 > 4){
-        DrawText("BONUS!", 100, 50, 1, WHITE);
-    }
-}
-
-//------------------------------------------------------------------------------------
-// * Background *
-//------------------------------------------------------------------------------------
-float backgroundOffset = 0.0f;
-int fadeTimer = 0;
-void updateBackground(){
-    backgroundSpeed += (backgroundSpeed < (MAX_BACKGROUND_SPEED * movedBackgrounds) + 3.5f) * 0.005f;
-    backgroundOffset += backgroundSpeed;
-    if (backgroundOffset > 400){
-        backgroundOffset -= 400;
-    }
-    Texture2D* spr;
-    switch (currentBackground){
-        case 0: spr = &mudBackground; break;
-        case 1: spr = &grassBackground; break;
-        case 2: spr = &sandBackground; break;
-            
-            
-    }
-    
-    // fading
-    fadeTimer -= fadeTimer > 0;
-    if (fadeTimer == 60){
-        currentBackground++;
-        currentBackground %= 3;
-        movedBackgrounds++;
-    }
-    
-    Color c = WHITE;
-    unsigned char dist = (abs(fadeTimer - 60.0f) / 60.0f) * 255;
-    c.r = dist;
-    c.g = dist;
-    c.b = dist;
-    
-    
-    
-    DrawTexture(*spr, 0, backgroundOffset, c);
-    DrawTexture(*spr, 0, backgroundOffset - 400, c);
-    
-    
-}
-
-void changeBackground(){
-    fadeTimer = 120;
-}
-
-
-
-
-//------------------------------------------------------------------------------------
-// Program main entry point
-//------------------------------------------------------------------------------------
-
-
-int main(void)
-{
-    // Initialization
-    //--------------------------------------------------------------------------------------
-    
-    const Color BACKGROUND_COLOR = {10, 0, 0};
-    struct Player playerObject = initPlayer();
-
-    InitWindow(windowWidth, windowHeight, "Educanet Blaster");
-    InitAudioDevice();
-    
-    loadSprites();
-    SetTargetFPS(60);               // Set our game to run at 60 frames-per-second
-    ToggleFullscreen();
-    //--------------------------------------------------------------------------------------
-    Camera2D cam = {};
-    cam.zoom = screenZoom;
-    float scalingFactor = screenWidth /(float)(GetScreenWidth());
-    int renderTextureOffset = ((GetScreenWidth()) / 2) - (screenWidth / 2);
-    
-    PlayMusicStream(music);
-    
-    
-    // Main game loop
-    while (!WindowShouldClose())    // Detect window close button or ESC key
-    {
-        UpdateMusicStream(music);
-        // Update
-        //----------------------------------------------------------------------------------
-        // TODO: Update your variables here
-        //----------------------------------------------------------------------------------
-
-        // Draw
-        //----------------------------------------------------------------------------------
-        BeginTextureMode(renderTexture);
-            BeginMode2D(cam);
-            ClearBackground(BACKGROUND_COLOR);
-            updateBackground();
-            updateExplosions();
-            if (playerObject.deadTimer == 120){
-                playerObject = initPlayer();
-                playerLives--;
-                if (playerLives == 0){
-                    PlaySound(gameOverSound);
-                }
-            }else if (playerLives > 0){
-                updatePlayer(&playerObject);
-            }else {
-                gameOver();
-            }
-            updateObjects();
-            updateEnemyManagement();
-            drawHud();
-            
-            EndMode2D();
-        EndTextureMode();
-        BeginDrawing();
-            ClearBackground(BACKGROUND_COLOR);
-            
-            Rectangle r = { 0, 0, (float)(renderTexture.texture.width), (float)(-renderTexture.texture.height) };
-            Rectangle r2 = { renderTextureOffset, 0, (float)(GetScreenWidth()) * scalingFactor, (float)(GetScreenHeight()) };
-            Vector2 v = {0, 0};
-            DrawTexturePro(
-                renderTexture.texture,
-                r,
-                r2,
-                v,
-                0,
-                WHITE);
-        
-        EndDrawing();
-        //----------------------------------------------------------------------------------
-    }
-
-    // De-Initialization
-    //--------------------------------------------------------------------------------------
-    CloseWindow();        // Close window and OpenGL context
-    //--------------------------------------------------------------------------------------
-    unloadSprites();
-    return 0;
-}
\ No newline at end of file
+/*******************************************************************************************
+*
+*   raylib [core] example - Basic window
+*
+*   Welcome to raylib!
+*
+*   To test examples, just press F6 and execute raylib_compile_execute script
+*   Note that compiled executable is placed in the same folder as .c file
+*
+*   You can find all basic examples on C:\raylib\raylib\examples folder or
+*   raylib official webpage: www.raylib.com
+*
+*   Enjoy using raylib. :)
+*
+*   Example originally created with raylib 1.0, last time updated with raylib 1.0
+*
+*   Example licensed under an unmodified zlib/libpng license, which is an OSI-certified,
+*   BSD-like license that allows static linking with closed source software
+*
+*   Copyright (c) 2013-2023 Ramon Santamaria (@raysan5)
+*
+********************************************************************************************/
+
+#include "raylib.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+//------------------------------------------------------------------------------------
+// * utility functions *
+//------------------------------------------------------------------------------------
+bool checkBoxCollisions(int x1, int y1, int w1, int h1, int x2, int y2, int w2, int h2){
+    return x1 + w1 > x2 &&
+           x1 < x2 + w2 &&
+           y1 + h1 > y2 &&
+           y1 < y2 + h2;
+}
+
+float lerp(float a, float b, float w){
+    return ((a - b) * w) + a;
+}
+
+int min(int a, int b){
+    if (a < b){
+        return a;
+    }
+    return b;
+}
+
+// xorshift generator. the game rolls on its world's state (see gameRandom), entities keep
+// their own so worker threads never share one
+int randomFrom(unsigned int* state, int min, int max){
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return min + (int)(*state % (unsigned int)(max - min + 1));
+}
+
+double getTimeSeconds(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1000000000.0;
+}
+
+long long getTimeNanos(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+
+//-------------------------------------------------------------------
+// * random vars *
+//-------------------------------------------------------------------
+
+const int screenWidth = 450;
+const int screenHeight = 700;
+const int windowWidth = 1280;
+const int windowHeight = 720;
+const float screenZoom = 2.0f;
+const int inGameWidth = (int)(screenWidth / screenZoom);
+const int inGameHeight = (int)(screenHeight / screenZoom);
+const float MAX_BACKGROUND_SPEED = 1.5f;
+// headless mode runs the simulation without a window, audio device or fps cap
+bool headless = false;
+
+
+
+//------------------------------------------------------------------------------------
+// * Forward declarations *
+//------------------------------------------------------------------------------------
+// sections further down that earlier ones call into
+struct GameWorld;       // see * Game world *
+struct Entities;
+
+// sound voices
+void loadVoices();
+void unloadVoices();
+
+// audio thread
+void stopAudioThread();
+
+// bullets
+void advanceBullets(struct Entities* bullets, int speed);
+void drawBullets(struct Entities* bullets, int sprite);
+
+// samuel
+void applyCommands(struct GameWorld* world);
+void updateEnemies(struct GameWorld* world);
+void drawEnemies(struct GameWorld* world);
+
+// enemy management
+void killedEnemy(struct GameWorld* world);
+
+// hud
+void drawHudLayer();
+void unloadHud();
+
+// background
+void changeBackground(struct GameWorld* world);
+
+
+
+//------------------------------------------------------------------------------------
+// * Input *
+//------------------------------------------------------------------------------------
+// the simulation never reads the keyboard itself, it gets one byte of key state per tick.
+// that byte can be written to a recording and fed back later for a replay.
+// recordings are a small header followed by (input, run length) triples
+#define INPUT_LEFT 1
+#define INPUT_RIGHT 2
+#define INPUT_UP 4
+#define INPUT_DOWN 8
+#define INPUT_FIRE 16
+#define INPUT_RESTART 32
+#define INPUT_BITS 8            // with more than one player each one's byte sits this much further up
+
+#define RECORDING_MAGIC 0x50524245 // "EBRP"
+#define RECORDING_VERSION 1
+#define MAX_INPUT_RUN 65535
+
+struct RecordingHeader{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int seed;
+    unsigned int ticks;
+};
+
+FILE* recordingFile = NULL;
+struct RecordingHeader recordingHeader;
+int recordingInput = -1;
+int recordingRun = 0;
+
+FILE* replayFile = NULL;
+int replayInput = 0;
+int replayRun = 0;
+unsigned int replayTicksLeft = 0;
+
+int readInput(){
+    int input = 0;
+    input |= IsKeyDown(KEY_LEFT) ? INPUT_LEFT : 0;
+    input |= IsKeyDown(KEY_RIGHT) ? INPUT_RIGHT : 0;
+    input |= IsKeyDown(KEY_UP) ? INPUT_UP : 0;
+    input |= IsKeyDown(KEY_DOWN) ? INPUT_DOWN : 0;
+    input |= IsKeyDown(KEY_SPACE) ? INPUT_FIRE : 0;
+    input |= IsKeyDown(KEY_R) ? INPUT_RESTART : 0;
+    return input;
+}
+
+int playerInput(int input, int slot){
+    return (input >> (INPUT_BITS * slot)) & ((1 << INPUT_BITS) - 1);
+}
+
+bool startRecording(const char* fileName, unsigned int seed){
+    recordingFile = fopen(fileName, "wb");
+    if (recordingFile == NULL){
+        printf("recording: can't open %s\n", fileName);
+        return false;
+    }
+    recordingHeader.magic = RECORDING_MAGIC;
+    recordingHeader.version = RECORDING_VERSION;
+    recordingHeader.seed = seed;
+    recordingHeader.ticks = 0;
+    fwrite(&recordingHeader, sizeof(recordingHeader), 1, recordingFile);
+    return true;
+}
+
+void writeInputRun(){
+    if (recordingRun == 0){
+        return;
+    }
+    unsigned char run[3] = { recordingInput, recordingRun & 0xff, recordingRun >> 8 };
+    fwrite(run, sizeof(run), 1, recordingFile);
+    recordingRun = 0;
+}
+
+void recordInput(int input){
+    if (recordingFile == NULL){
+        return;
+    }
+    if (input != recordingInput || recordingRun == MAX_INPUT_RUN){
+        writeInputRun();
+        recordingInput = input;
+    }
+    recordingRun++;
+    recordingHeader.ticks++;
+}
+
+void stopRecording(){
+    if (recordingFile == NULL){
+        return;
+    }
+    writeInputRun();
+    fseek(recordingFile, 0, SEEK_SET);
+    fwrite(&recordingHeader, sizeof(recordingHeader), 1, recordingFile);
+    fclose(recordingFile);
+    recordingFile = NULL;
+    printf("recording: %u ticks saved\n", recordingHeader.ticks);
+}
+
+// opens a recording and hands back the seed the game has to start from
+bool startReplay(const char* fileName, unsigned int* seed){
+    struct RecordingHeader header;
+    replayFile = fopen(fileName, "rb");
+    if (replayFile == NULL || fread(&header, sizeof(header), 1, replayFile) != 1 ||
+        header.magic != RECORDING_MAGIC || header.version != RECORDING_VERSION){
+        printf("replay: %s is not a recording\n", fileName);
+        return false;
+    }
+    *seed = header.seed;
+    replayTicksLeft = header.ticks;
+    return true;
+}
+
+bool replayFinished(){
+    return replayTicksLeft == 0;
+}
+
+int nextReplayInput(){
+    if (replayRun == 0){
+        unsigned char run[3];
+        if (fread(run, sizeof(run), 1, replayFile) != 1){
+            replayTicksLeft = 0;
+            return 0;
+        }
+        replayInput = run[0];
+        replayRun = run[1] | (run[2] << 8);
+    }
+    replayRun--;
+    replayTicksLeft--;
+    return replayInput;
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Profiler *
+//------------------------------------------------------------------------------------
+// every stage of the main loop is timed with the monotonic clock. the last
+// PROFILE_HISTORY frames are kept for the overlay (F3), and every frame can be
+// appended to a csv or json lines file for graphing later.
+// stages that run more than once in a frame add up
+#define PROFILE_BACKGROUND 0
+#define PROFILE_EXPLOSIONS 1
+#define PROFILE_PLAYER 2
+#define PROFILE_OBJECTS 3
+#define PROFILE_COLLISIONS 4
+#define PROFILE_ENEMY_MANAGEMENT 5
+#define PROFILE_HUD 6
+#define PROFILE_DRAW 7
+#define PROFILE_UPSCALE 8
+#define PROFILE_PRESENT 9
+#define PROFILE_FRAME 10
+#define PROFILE_STAGE_COUNT 11
+#define PROFILE_HISTORY 240
+
+const char* profileStageNames[PROFILE_STAGE_COUNT] = {
+    "background",
+    "explosions",
+    "player",
+    "objects",
+    "collisions",
+    "enemy_management",
+    "hud",
+    "draw",
+    "upscale",
+    "present",
+    "frame",
+};
+
+long long profileStarts[PROFILE_STAGE_COUNT];
+float profileSamples[PROFILE_HISTORY][PROFILE_STAGE_COUNT];
+long profileFrames = 0;
+// headless runs only pay for the clock reads when they log to a file
+bool profilerEnabled = true;
+bool showProfiler = false;
+FILE* profileFile = NULL;
+bool profileJson = false;
+
+// the file name decides the format, .jsonl gets json lines and anything else csv
+bool startProfileLog(const char* fileName){
+    profileFile = fopen(fileName, "w");
+    if (profileFile == NULL){
+        printf("profiler: can't open %s\n", fileName);
+        return false;
+    }
+    
+    int length = strlen(fileName);
+    profileJson = length > 6 && strcmp(fileName + length - 6, ".jsonl") == 0;
+    if (!profileJson){
+        fprintf(profileFile, "frame");
+        for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++){
+            fprintf(profileFile, ",%s_ms", profileStageNames[stage]);
+        }
+        fprintf(profileFile, "\n");
+    }
+    return true;
+}
+
+void stopProfileLog(){
+    if (profileFile != NULL){
+        fclose(profileFile);
+        profileFile = NULL;
+    }
+}
+
+void profileBegin(int stage){
+    if (profilerEnabled){
+        profileStarts[stage] = getTimeNanos();
+    }
+}
+
+void profileEnd(int stage){
+    if (!profilerEnabled){
+        return;
+    }
+    profileSamples[profileFrames % PROFILE_HISTORY][stage] += (getTimeNanos() - profileStarts[stage]) / 1000000.0f;
+}
+
+void profileFrameBegin(){
+    if (!profilerEnabled){
+        return;
+    }
+    float* row = profileSamples[profileFrames % PROFILE_HISTORY];
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++){
+        row[stage] = 0;
+    }
+    profileBegin(PROFILE_FRAME);
+}
+
+void profileFrameEnd(){
+    if (!profilerEnabled){
+        return;
+    }
+    profileEnd(PROFILE_FRAME);
+    float* row = profileSamples[profileFrames % PROFILE_HISTORY];
+    
+    if (profileFile != NULL){
+        if (profileJson){
+            fprintf(profileFile, "{\"frame\":%ld", profileFrames);
+            for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++){
+                fprintf(profileFile, ",\"%s\":%.4f", profileStageNames[stage], row[stage]);
+            }
+            fprintf(profileFile, "}\n");
+        }else {
+            fprintf(profileFile, "%ld", profileFrames);
+            for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++){
+                fprintf(profileFile, ",%.4f", row[stage]);
+            }
+            fprintf(profileFile, "\n");
+        }
+    }
+    profileFrames++;
+}
+
+int compareFloats(const void* a, const void* b){
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+// every timing and bench table reads its percentiles from here
+struct Percentiles{
+    float p10;
+    float p50;
+    float p90;
+    float p95;
+    float p99;
+    float worst;
+};
+
+// the samples themselves are left alone, all zero when there are none. the overlay asks
+// for every stage every frame, so up to a profiler history is sorted in a buffer that
+// stays around. only the exit summaries and bench tables have more and allocate.
+// main thread only
+float percentileScratch[PROFILE_HISTORY];
+
+struct Percentiles percentiles(const float* samples, int count){
+    struct Percentiles result = { 0 };
+    if (count <= 0){
+        return result;
+    }
+    float* sorted = count <= PROFILE_HISTORY ? percentileScratch : malloc(sizeof(float) * count);
+    if (sorted == NULL){
+        return result;
+    }
+    memcpy(sorted, samples, sizeof(float) * count);
+    qsort(sorted, count, sizeof(float), compareFloats);
+    result.p10 = sorted[count / 10];
+    result.p50 = sorted[count / 2];
+    result.p90 = sorted[(int)((count - 1) * 0.9f)];
+    result.p95 = sorted[(int)((count - 1) * 0.95f)];
+    result.p99 = sorted[(int)((count - 1) * 0.99f)];
+    result.worst = sorted[count - 1];
+    if (sorted != percentileScratch){
+        free(sorted);
+    }
+    return result;
+}
+
+// average and p99 of a stage over the frames still in the history
+void profileStats(int stage, float* average, float* p99){
+    int count = profileFrames < PROFILE_HISTORY ? profileFrames : PROFILE_HISTORY;
+    float samples[PROFILE_HISTORY];
+    float sum = 0;
+    for (int i = 0; i < count; i++){
+        samples[i] = profileSamples[i][stage];
+        sum += samples[i];
+    }
+    *average = count > 0 ? sum / count : 0;
+    *p99 = percentiles(samples, count).p99;
+}
+
+// frame to frame times of the windowed loop, separate from the stage timings so a
+// frame that waits on vsync still shows up. a hiccup is a frame that took
+// HICCUP_FACTOR times longer than the average so far
+#define HICCUP_FACTOR 1.5
+#define PACING_WARMUP 30            // the first frames after the window opens are always slow
+
+long pacingFrames = 0;
+long pacingTicks = 0;
+long pacingDroppedTicks = 0;
+long pacingHiccups = 0;
+double pacingSum = 0;
+double pacingSquares = 0;
+double pacingMax = 0;
+
+void recordFramePacing(double frameTime){
+    pacingFrames++;
+    if (pacingFrames <= PACING_WARMUP){
+        return;
+    }
+    long counted = pacingFrames - PACING_WARMUP;
+    if (counted > 1 && frameTime > HICCUP_FACTOR * pacingSum / (counted - 1)){
+        pacingHiccups++;
+    }
+    pacingSum += frameTime;
+    pacingSquares += frameTime * frameTime;
+    pacingMax = frameTime > pacingMax ? frameTime : pacingMax;
+}
+
+void pacingStats(double* average, double* deviation){
+    long counted = pacingFrames - PACING_WARMUP;
+    if (counted <= 0){
+        *average = 0;
+        *deviation = 0;
+        return;
+    }
+    *average = pacingSum / counted;
+    double variance = pacingSquares / counted - *average * *average;
+    *deviation = variance > 0 ? sqrt(variance) : 0;
+}
+
+void printFramePacing(){
+    double average;
+    double deviation;
+    pacingStats(&average, &deviation);
+    printf("frames: %ld, ticks: %ld, %ld dropped\n", pacingFrames, pacingTicks, pacingDroppedTicks);
+    printf("frame time: %.3f ms avg, %.3f ms stddev, %.3f ms max, %ld hiccups\n",
+        average * 1000, deviation * 1000, pacingMax * 1000, pacingHiccups);
+}
+
+// drawn straight onto the screen after the upscale, so it stays readable at any zoom
+void drawProfilerOverlay(){
+    DrawRectangle(5, 5, 330, 38 + PROFILE_STAGE_COUNT * 18, (Color){ 0, 0, 0, 180 });
+    DrawText("STAGE              AVG MS   P99 MS", 10, 10, 10, YELLOW);
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++){
+        float average;
+        float p99;
+        profileStats(stage, &average, &p99);
+        Color c = p99 > 16.6f ? RED : WHITE;
+        DrawText(TextFormat("%-18s %7.3f  %7.3f", profileStageNames[stage], average, p99), 10, 28 + stage * 18, 10, c);
+    }
+    
+    double frameAverage;
+    double frameDeviation;
+    pacingStats(&frameAverage, &frameDeviation);
+    DrawText(TextFormat("pacing %.2f +- %.2f ms, max %.2f, %ld hiccups", frameAverage * 1000, frameDeviation * 1000, pacingMax * 1000, pacingHiccups),
+        10, 28 + PROFILE_STAGE_COUNT * 18, 10, pacingHiccups > 0 ? ORANGE : WHITE);
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Input latency *
+//------------------------------------------------------------------------------------
+// raylib reads the keyboard in EndDrawing, right after the swap. with vsync that is just
+// after a vblank, so whatever the frame simulates was pressed a whole frame before it
+// shows. late input waits out the part of the frame the work doesn't need, with the
+// slowest recent frame and a margin as the estimate, and reads the keyboard only then.
+// every change of the input is timed until the first frame presented after a tick ran
+// on it, the percentiles go into the exit summary and the stats overlay (F2)
+#define LATENCY_SAMPLES 4096
+#define WORK_HISTORY 30
+#define LATE_INPUT_MARGIN 0.0015    // seconds kept free between the estimated end of the work and the vblank
+
+bool lateInput = true;
+float latencySamples[LATENCY_SAMPLES];     // ms, a ring once it is full
+long latencyCount = 0;
+int polledInput = 0;
+double pendingChange = -1;      // when the oldest change not on screen yet happened, -1 for none
+bool pendingSimulated = false;
+float workHistory[WORK_HISTORY];
+long workFrames = 0;
+
+// changeTime is the best guess at when it changed, a poll can't tell where in between two polls that was
+void noteInputPoll(int input, double changeTime){
+    if (input != polledInput && pendingChange < 0){
+        pendingChange = changeTime;
+        pendingSimulated = false;
+    }
+    polledInput = input;
+}
+
+void noteInputSimulated(){
+    pendingSimulated = pendingChange >= 0;
+}
+
+void noteFramePresented(double now){
+    if (!pendingSimulated){
+        return;
+    }
+    latencySamples[latencyCount % LATENCY_SAMPLES] = (now - pendingChange) * 1000;
+    latencyCount++;
+    pendingChange = -1;
+    pendingSimulated = false;
+}
+
+void clearLatency(){
+    latencyCount = 0;
+    pendingChange = -1;
+    pendingSimulated = false;
+    workFrames = 0;
+}
+
+struct Percentiles latencyPercentiles(){
+    return percentiles(latencySamples, latencyCount < LATENCY_SAMPLES ? latencyCount : LATENCY_SAMPLES);
+}
+
+void printLatency(const char* label){
+    struct Percentiles latency = latencyPercentiles();
+    printf("%-12s %8ld %8.2f %8.2f %8.2f %8.2f\n", label, latencyCount, latency.p50, latency.p95, latency.p99, latency.worst);
+}
+
+// poll to just before the present, the part of a frame late input has to leave room for
+void recordFrameWork(double seconds){
+    workHistory[workFrames++ % WORK_HISTORY] = seconds;
+}
+
+// drawn on the screen with the other stats (F2)
+void drawLatencyStats(){
+    struct Percentiles latency = latencyPercentiles();
+    DrawText(TextFormat("INPUT TO PRESENT %.1f MS P50 %.1f P95 %.1f P99, %s INPUT", latency.p50, latency.p95, latency.p99, lateInput ? "LATE" : "EARLY"),
+        10, GetScreenHeight() - 80, 10, WHITE);
+}
+
+// when to read the input for a frame that should be on screen at present
+double lateInputPollTime(double present){
+    int count = workFrames < WORK_HISTORY ? workFrames : WORK_HISTORY;
+    float slowest = 0;
+    for (int i = 0; i < count; i++){
+        slowest = workHistory[i] > slowest ? workHistory[i] : slowest;
+    }
+    return present - slowest - LATE_INPUT_MARGIN;
+}
+
+// sleeps most of the way and spins the rest, usleep alone overshoots by too much
+void waitUntil(double time){
+    double left = time - getTimeSeconds();
+    if (left > 0.002){
+        usleep((useconds_t)((left - 0.001) * 1000000));
+    }
+    while (getTimeSeconds() < time){
+    }
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Workers *
+//------------------------------------------------------------------------------------
+// a job splits [0, count) into one contiguous range per worker, the main thread
+// takes range 0 and waits for the rest. jobs never touch shared state directly,
+// anything that spawns, removes or scores goes into the worker's command buffer
+// and applyCommands replays the buffers in worker order, which is the same order
+// a single thread would have produced them in.
+// a job only goes wide when its share of the items saves more than waking the workers
+// costs. that cost is timed when they start, each job's cost per item is timed on its
+// single threaded runs, so whether it pays follows the machine and the job instead of
+// a fixed item count
+#define MAX_WORKERS 16
+#define WAKE_SAMPLES 64
+#define MAX_JOB_KINDS 4
+#define JOB_COST_SMOOTHING 0.0625f  // weight of the newest single threaded run
+
+typedef void (*JobFunction)(struct GameWorld* world, int worker, int first, int last);
+
+int workerCount = 1;
+pthread_t workerThreads[MAX_WORKERS];
+pthread_mutex_t workerLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t workerWake = PTHREAD_COND_INITIALIZER;
+pthread_cond_t workerDone = PTHREAD_COND_INITIALIZER;
+JobFunction currentJob;
+struct GameWorld* currentJobWorld;
+int currentJobCount = 0;
+long jobGeneration = 0;
+int jobsPending = 0;
+bool workersQuit = false;
+
+float workerWakeCost = 0;           // us, the median of handing an empty job to every worker
+
+struct JobCost{
+    JobFunction job;
+    const char* name;
+    float itemCost;                 // us, smoothed over its single threaded runs
+    int peakCount;
+    long runs;
+    long parallelRuns;
+};
+struct JobCost jobCosts[MAX_JOB_KINDS];
+int jobKinds = 0;
+
+struct JobCost* findJobCost(JobFunction job, const char* name){
+    for (int i = 0; i < jobKinds; i++){
+        if (jobCosts[i].job == job){
+            return &jobCosts[i];
+        }
+    }
+    if (jobKinds == MAX_JOB_KINDS){
+        return NULL;
+    }
+    struct JobCost* cost = &jobCosts[jobKinds++];
+    memset(cost, 0, sizeof(*cost));
+    cost->job = job;
+    cost->name = name;
+    return cost;
+}
+
+// the items the other workers take off the main thread have to be worth more than the wake
+int breakEvenItems(const struct JobCost* cost){
+    if (cost->itemCost <= 0 || workerCount == 1){
+        return 0;
+    }
+    return (int)(workerWakeCost * workerCount / ((workerCount - 1) * cost->itemCost)) + 1;
+}
+
+void runJobRange(int worker){
+    int first = (int)((long)currentJobCount * worker / workerCount);
+    int last = (int)((long)currentJobCount * (worker + 1) / workerCount);
+    if (first < last){
+        currentJob(currentJobWorld, worker, first, last);
+    }
+}
+
+void* workerMain(void* argument){
+    int worker = (int)(long)argument;
+    long seen = 0;
+    
+    pthread_mutex_lock(&workerLock);
+    while (true){
+        while (jobGeneration == seen && !workersQuit){
+            pthread_cond_wait(&workerWake, &workerLock);
+        }
+        if (workersQuit){
+            break;
+        }
+        seen = jobGeneration;
+        pthread_mutex_unlock(&workerLock);
+        
+        runJobRange(worker);
+        
+        pthread_mutex_lock(&workerLock);
+        if (--jobsPending == 0){
+            pthread_cond_signal(&workerDone);
+        }
+    }
+    pthread_mutex_unlock(&workerLock);
+    return NULL;
+}
+
+void wakeWorkers(struct GameWorld* world, JobFunction job, int count){
+    pthread_mutex_lock(&workerLock);
+    currentJob = job;
+    currentJobWorld = world;
+    currentJobCount = count;
+    jobsPending = workerCount - 1;
+    jobGeneration++;
+    pthread_cond_broadcast(&workerWake);
+    pthread_mutex_unlock(&workerLock);
+    
+    runJobRange(0);
+    
+    pthread_mutex_lock(&workerLock);
+    while (jobsPending > 0){
+        pthread_cond_wait(&workerDone, &workerLock);
+    }
+    pthread_mutex_unlock(&workerLock);
+}
+
+void runParallel(struct GameWorld* world, const char* name, JobFunction job, int count){
+    if (workerCount == 1){
+        job(world, 0, 0, count);
+        return;
+    }
+    
+    struct JobCost* cost = findJobCost(job, name);
+    if (cost == NULL){
+        wakeWorkers(world, job, count);
+        return;
+    }
+    cost->runs++;
+    if (count > cost->peakCount){
+        cost->peakCount = count;
+    }
+    int breakEven = breakEvenItems(cost);
+    if (breakEven > 0 && count >= breakEven){
+        cost->parallelRuns++;
+        wakeWorkers(world, job, count);
+        return;
+    }
+    
+    long long start = getTimeNanos();
+    job(world, 0, 0, count);
+    if (count > 0){
+        float itemCost = (getTimeNanos() - start) / 1000.0f / count;
+        cost->itemCost = cost->itemCost == 0 ? itemCost : cost->itemCost + (itemCost - cost->itemCost) * JOB_COST_SMOOTHING;
+    }
+}
+
+void emptyJob(struct GameWorld* world, int worker, int first, int last){
+}
+
+void measureWorkerWake(){
+    float samples[WAKE_SAMPLES];
+    for (int i = 0; i < WAKE_SAMPLES; i++){
+        long long start = getTimeNanos();
+        wakeWorkers(NULL, emptyJob, workerCount);
+        samples[i] = (getTimeNanos() - start) / 1000.0f;
+    }
+    workerWakeCost = percentiles(samples, WAKE_SAMPLES).p50;
+}
+
+// how far each job got from paying for the wake, a job that never reached its break even
+// point ran single threaded the whole time
+void printWorkerStats(){
+    if (workerCount == 1){
+        return;
+    }
+    printf("workers: %i threads, waking them costs %.1f us\n", workerCount, workerWakeCost);
+    for (int i = 0; i < jobKinds; i++){
+        const struct JobCost* cost = &jobCosts[i];
+        printf("  %-18s %.3f us per item, pays from %i items, peak %i, %ld of %ld runs wide\n",
+            cost->name, cost->itemCost, breakEvenItems(cost), cost->peakCount, cost->parallelRuns, cost->runs);
+    }
+}
+
+int defaultWorkerCount(){
+#ifdef _SC_NPROCESSORS_ONLN
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores < 1 ? 1 : (int)min((int)cores, MAX_WORKERS);
+#else
+    return 1;
+#endif
+}
+
+void startWorkers(int count){
+    workerCount = count < 1 ? 1 : min(count, MAX_WORKERS);
+    for (int worker = 1; worker < workerCount; worker++){
+        if (pthread_create(&workerThreads[worker], NULL, workerMain, (void*)(long)worker) != 0){
+            printf("could not start worker %i, running on %i threads\n", worker, worker);
+            workerCount = worker;
+            break;
+        }
+    }
+    jobKinds = 0;
+    if (workerCount > 1){
+        measureWorkerWake();
+    }
+}
+
+void stopWorkers(){
+    pthread_mutex_lock(&workerLock);
+    workersQuit = true;
+    pthread_cond_broadcast(&workerWake);
+    pthread_mutex_unlock(&workerLock);
+    
+    for (int worker = 1; worker < workerCount; worker++){
+        pthread_join(workerThreads[worker], NULL);
+    }
+    workerCount = 1;
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Software renderer *
+//------------------------------------------------------------------------------------
+// the same 450x700 frame drawn into an rgba framebuffer on the cpu, for machines
+// without a gpu and for comparing frames against golden images. sprites are sampled
+// nearest neighbour like raylib's default point filter, tinted and alpha blended the
+// way raylib's vertex colors and BLEND_ALPHA do. text uses a built in 3x5 font, so it
+// only looks like raylib's in size and place
+bool softwareRender = false;
+bool scalarBlend = false;          // skips the sse2 blend, kept around for comparisons
+Color* framebuffer = NULL;
+int framebufferRows = screenHeight;  // what drawing clips to, the hud layer is only its top rows
+Color blitRow[1024];                // one gathered row of a blit, wider than the framebuffer
+int blitColumns[1024];
+long softwareFrames = 0;
+double softwareRenderTime = 0;
+
+// 3x5 glyphs for ' ' to '_', bit row * 3 + column is set for every lit pixel
+const unsigned short softwareFont[64] = {
+    0x0000, 0x2092, 0x002d, 0x5f7d, 0x3c9e, 0x52a5, 0x6aaa, 0x0012,
+    0x224a, 0x2922, 0x0155, 0x05d0, 0x1400, 0x01c0, 0x2000, 0x12a4,
+    0x7b6f, 0x749a, 0x73e7, 0x79e7, 0x49ed, 0x79cf, 0x7bcf, 0x2527,
+    0x7bef, 0x79ef, 0x0410, 0x1410, 0x4454, 0x0e38, 0x1511, 0x20a7,
+    0x636f, 0x5bea, 0x3aeb, 0x624e, 0x3b6b, 0x72cf, 0x12cf, 0x6b4e,
+    0x5bed, 0x7497, 0x2b24, 0x5aed, 0x7249, 0x5bfd, 0x5b6b, 0x2b6a,
+    0x12eb, 0x676a, 0x5aeb, 0x388e, 0x2497, 0x7b6d, 0x2b6d, 0x5fed,
+    0x5aad, 0x24ad, 0x72a7, 0x324b, 0x4889, 0x6926, 0x002a, 0x7000,
+};
+
+bool startSoftwareRenderer(){
+    framebuffer = malloc(sizeof(Color) * screenWidth * screenHeight);
+    if (framebuffer == NULL){
+        printf("software render: out of memory for the framebuffer\n");
+        return false;
+    }
+    return true;
+}
+
+void stopSoftwareRenderer(){
+    unloadHud();
+    free(framebuffer);
+    framebuffer = NULL;
+}
+
+void clearFramebuffer(Color color){
+    for (int i = 0; i < screenWidth * screenHeight; i++){
+        framebuffer[i] = color;
+    }
+}
+
+// a * b / 255 rounded to nearest, exact for every pair of bytes
+int multiply255(int a, int b){
+    int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// src tinted and drawn over dst: color = src * a + dst * (1 - a), alpha = a + dst alpha * (1 - a)
+void blendSpanScalar(Color* dst, const Color* src, int count, Color tint){
+    for (int i = 0; i < count; i++){
+        int a = multiply255(src[i].a, tint.a);
+        int inverse = 255 - a;
+        dst[i].r = multiply255(multiply255(src[i].r, tint.r), a) + multiply255(dst[i].r, inverse);
+        dst[i].g = multiply255(multiply255(src[i].g, tint.g), a) + multiply255(dst[i].g, inverse);
+        dst[i].b = multiply255(multiply255(src[i].b, tint.b), a) + multiply255(dst[i].b, inverse);
+        dst[i].a = a + multiply255(dst[i].a, inverse);
+    }
+}
+
+#if defined(__SSE2__)
+__m128i multiply255x8(__m128i a, __m128i b){
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// two pixels as 16 bit channels, gives bit for bit what blendSpanScalar gives
+__m128i blendPixels2(__m128i s, __m128i d, __m128i tint){
+    const __m128i colorLanes = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaLanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    s = multiply255x8(s, tint);
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    // the alpha channel itself is kept as is instead of multiplied by alpha again
+    __m128i sourceWeight = _mm_or_si128(_mm_and_si128(a, colorLanes), alphaLanes);
+    __m128i destinationWeight = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return _mm_add_epi16(multiply255x8(s, sourceWeight), multiply255x8(d, destinationWeight));
+}
+#endif
+
+const char* blendKernelName(){
+#if defined(__SSE2__)
+    return scalarBlend ? "scalar" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void blendSpan(Color* dst, const Color* src, int count, Color tint){
+    int i = 0;
+#if defined(__SSE2__)
+    if (!scalarBlend){
+        __m128i zero = _mm_setzero_si128();
+        __m128i tint2 = _mm_set_epi16(tint.a, tint.b, tint.g, tint.r, tint.a, tint.b, tint.g, tint.r);
+        for (; i + 4 <= count; i += 4){
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            __m128i low = blendPixels2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), tint2);
+            __m128i high = blendPixels2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), tint2);
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(low, high));
+        }
+    }
+#endif
+    blendSpanScalar(dst + i, src + i, count - i, tint);
+}
+
+// first and one past the last framebuffer pixel whose center falls inside [start, start + size)
+void coveredPixels(float start, float size, int limit, int* first, int* last){
+    *first = (int)ceilf(start - 0.5f);
+    *last = (int)ceilf(start + size - 0.5f);
+    *first = *first < 0 ? 0 : *first;
+    *last = *last > limit ? limit : *last;
+}
+
+// source rectangle of an atlas page to a rectangle of the framebuffer, both in pixels
+void blitImage(Image* page, Rectangle source, float x, float y, float width, float height, Color tint){
+    int firstX, lastX, firstY, lastY;
+    coveredPixels(x, width, screenWidth, &firstX, &lastX);
+    coveredPixels(y, height, framebufferRows, &firstY, &lastY);
+    if (firstX >= lastX || firstY >= lastY){
+        return;
+    }
+    
+    const Color* pixels = page->data;
+    float stepX = source.width / width;
+    float stepY = source.height / height;
+    for (int px = firstX; px < lastX; px++){
+        int column = (int)((px + 0.5f - x) * stepX);
+        blitColumns[px - firstX] = (int)source.x + min(column, (int)source.width - 1);
+    }
+    
+    int count = lastX - firstX;
+    for (int py = firstY; py < lastY; py++){
+        int row = min((int)((py + 0.5f - y) * stepY), (int)source.height - 1);
+        const Color* sourceRow = pixels + ((int)source.y + row) * page->width;
+        for (int n = 0; n < count; n++){
+            blitRow[n] = sourceRow[blitColumns[n]];
+        }
+        blendSpan(framebuffer + py * screenWidth + firstX, blitRow, count, tint);
+    }
+}
+
+void softwareDrawSprite(Image* page, Rectangle source, float x, float y, float scale, Color tint){
+    blitImage(page, source, x * screenZoom, y * screenZoom, source.width * scale * screenZoom, source.height * scale * screenZoom, tint);
+}
+
+void softwareFillRect(int x, int y, int width, int height, Color color){
+    int firstX = x < 0 ? 0 : x;
+    int lastX = min(x + width, screenWidth);
+    for (int n = 0; n < lastX - firstX; n++){
+        blitRow[n] = color;
+    }
+    for (int py = y < 0 ? 0 : y; py < min(y + height, framebufferRows); py++){
+        blendSpan(framebuffer + py * screenWidth + firstX, blitRow, lastX - firstX, WHITE);
+    }
+}
+
+// raylib never draws its default font smaller than 10, a glyph is 3x5 cells of fontSize / 5
+void softwareDrawText(const char* text, float x, float y, int fontSize, Color color){
+    int size = fontSize < 10 ? 10 : fontSize;
+    int cell = (int)(size / 5 * screenZoom);
+    int penX = (int)(x * screenZoom);
+    int penY = (int)(y * screenZoom);
+    for (const char* c = text; *c != '\0'; c++){
+        int code = *c >= 'a' && *c <= 'z' ? *c - 32 : *c;
+        unsigned short glyph = code >= 32 && code < 96 ? softwareFont[code - 32] : softwareFont['?' - 32];
+        for (int bit = 0; bit < 15; bit++){
+            if (glyph & (1 << bit)){
+                softwareFillRect(penX + (bit % 3) * cell, penY + (bit / 3) * cell, cell, cell, color);
+            }
+        }
+        penX += 4 * cell;
+    }
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Frame capture *
+//------------------------------------------------------------------------------------
+// finished frames are copied into a fixed ring of slots that a writer thread drains
+// to disk, either as one y4m video or as a numbered png per frame. the main thread
+// only ever fills the slot at the tail and the writer only ever empties the one at
+// the head, so the two never take a lock. a windowed run drops the frame when every
+// slot is taken, a headless run has no deadline and waits for the writer instead.
+// a y4m plays at the tick rate: each frame carries the simulation ticks it stands for
+// and is written once per tick, whatever rate the display presents at. a frame with no
+// tick since the last one isn't queued, a dropped frame's ticks go to the next one
+#define CAPTURE_SLOTS 8
+#define CAPTURE_Y4M 0
+#define CAPTURE_PNG 1
+
+struct CaptureSlot{
+    Color* pixels;
+    long frame;
+    int ticks;
+    bool flipped;       // gpu readback comes out bottom row first
+};
+
+struct CaptureSlot captureSlots[CAPTURE_SLOTS];
+atomic_uint captureHead = 0;
+atomic_uint captureTail = 0;
+atomic_bool captureQuit = false;
+bool capturing = false;
+int captureFormat = CAPTURE_Y4M;
+const char* captureFileName = NULL;
+FILE* captureFile = NULL;
+pthread_t captureWriter;
+long captureFrames = 0;             // offered to the queue, written or not
+long captureTicks = 0;
+int captureOwedTicks = 0;           // since the last frame that made it into the queue
+long captureDropped = 0;
+long captureWaits = 0;
+long captureReadbacks = 0;          // gpu frames, see readBackCaptureTarget
+double captureReadbackTime = 0;     // s, reading back and queueing, all of it on the main thread
+double captureReadbackWorst = 0;
+atomic_long captureWritten = 0;
+int captureDepthMax = 0;
+unsigned char* capturePlanes = NULL;
+Color* captureFlipped = NULL;
+
+int captureQueueDepth(){
+    return atomic_load(&captureTail) - atomic_load(&captureHead);
+}
+
+// full range bt.601, what the C420jpeg tag in the header promises
+void writeY4mFrame(const Color* pixels){
+    int w = screenWidth;
+    int h = screenHeight;
+    unsigned char* luma = capturePlanes;
+    unsigned char* blue = luma + w * h;
+    unsigned char* red = blue + (w / 2) * (h / 2);
+    for (int i = 0; i < w * h; i++){
+        luma[i] = (77 * pixels[i].r + 150 * pixels[i].g + 29 * pixels[i].b) >> 8;
+    }
+    for (int y = 0; y < h / 2; y++){
+        for (int x = 0; x < w / 2; x++){
+            const Color* p = pixels + y * 2 * w + x * 2;
+            int r = (p[0].r + p[1].r + p[w].r + p[w + 1].r) / 4;
+            int g = (p[0].g + p[1].g + p[w].g + p[w + 1].g) / 4;
+            int b = (p[0].b + p[1].b + p[w].b + p[w + 1].b) / 4;
+            blue[y * (w / 2) + x] = ((-43 * r - 85 * g + 128 * b) >> 8) + 128;
+            red[y * (w / 2) + x] = ((128 * r - 107 * g - 21 * b) >> 8) + 128;
+        }
+    }
+}
+
+void writeCaptureSlot(struct CaptureSlot* slot){
+    const Color* pixels = slot->pixels;
+    if (slot->flipped){
+        for (int y = 0; y < screenHeight; y++){
+            memcpy(captureFlipped + y * screenWidth, slot->pixels + (screenHeight - 1 - y) * screenWidth, sizeof(Color) * screenWidth);
+        }
+        pixels = captureFlipped;
+    }
+    
+    if (captureFormat == CAPTURE_Y4M){
+        writeY4mFrame(pixels);
+        for (int t = 0; t < slot->ticks; t++){
+            fputs("FRAME\n", captureFile);
+            fwrite(capturePlanes, 1, screenWidth * screenHeight + 2 * (screenWidth / 2) * (screenHeight / 2), captureFile);
+        }
+    }else {
+        char fileName[512];
+        snprintf(fileName, sizeof(fileName), captureFileName, (int)slot->frame);
+        ExportImage((Image){ (void*)pixels, screenWidth, screenHeight, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }, fileName);
+    }
+}
+
+void* captureWriterMain(void* argument){
+    while (true){
+        unsigned int head = atomic_load_explicit(&captureHead, memory_order_relaxed);
+        if (head == atomic_load_explicit(&captureTail, memory_order_acquire)){
+            if (atomic_load(&captureQuit)){
+                break;
+            }
+            usleep(1000);
+            continue;
+        }
+        writeCaptureSlot(&captureSlots[head % CAPTURE_SLOTS]);
+        atomic_fetch_add(&captureWritten, 1);
+        atomic_store_explicit(&captureHead, head + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+// a path ending in .y4m gets one video, anything else is a printf pattern for pngs like shots/frame%05d.png
+bool startCapture(const char* path, int tickRate){
+    int length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".y4m") == 0){
+        captureFormat = CAPTURE_Y4M;
+        captureFile = fopen(path, "wb");
+        if (captureFile == NULL){
+            printf("capture: can't open %s\n", path);
+            return false;
+        }
+        fprintf(captureFile, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C420jpeg\n", screenWidth, screenHeight, tickRate);
+    }else if (strchr(path, '%') != NULL){
+        captureFormat = CAPTURE_PNG;
+    }else {
+        printf("capture: %s is neither a .y4m file nor a png pattern like frame%%05d.png\n", path);
+        return false;
+    }
+    captureFileName = path;
+    
+    capturePlanes = malloc(screenWidth * screenHeight * 2);
+    captureFlipped = malloc(sizeof(Color) * screenWidth * screenHeight);
+    bool allocated = capturePlanes != NULL && captureFlipped != NULL;
+    for (int s = 0; s < CAPTURE_SLOTS; s++){
+        captureSlots[s].pixels = malloc(sizeof(Color) * screenWidth * screenHeight);
+        allocated = allocated && captureSlots[s].pixels != NULL;
+    }
+    if (!allocated || pthread_create(&captureWriter, NULL, captureWriterMain, NULL) != 0){
+        printf("capture: can't start the writer\n");
+        return false;
+    }
+    capturing = true;
+    return true;
+}
+
+// copies a finished frame into the queue, never blocks a windowed run. ticks is how many
+// simulation ticks went by since the frame before it
+void captureFrame(const Color* pixels, bool flipped, int ticks){
+    if (!capturing){
+        return;
+    }
+    captureTicks += ticks;
+    captureOwedTicks += ticks;
+    if (captureOwedTicks == 0){
+        return;
+    }
+    long frame = captureFrames++;
+    unsigned int tail = atomic_load_explicit(&captureTail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&captureHead, memory_order_acquire) == CAPTURE_SLOTS){
+        if (!headless){
+            captureDropped++;
+            return;
+        }
+        captureWaits++;
+        usleep(100);
+    }
+    
+    struct CaptureSlot* slot = &captureSlots[tail % CAPTURE_SLOTS];
+    memcpy(slot->pixels, pixels, sizeof(Color) * screenWidth * screenHeight);
+    slot->frame = frame;
+    slot->ticks = captureOwedTicks;
+    slot->flipped = flipped;
+    captureOwedTicks = 0;
+    atomic_store_explicit(&captureTail, tail + 1, memory_order_release);
+    
+    int depth = captureQueueDepth();
+    captureDepthMax = depth > captureDepthMax ? depth : captureDepthMax;
+}
+
+// lets the writer empty the queue before it goes
+void stopCapture(){
+    if (!capturing){
+        return;
+    }
+    atomic_store(&captureQuit, true);
+    pthread_join(captureWriter, NULL);
+    if (captureFile != NULL){
+        fclose(captureFile);
+        captureFile = NULL;
+    }
+    for (int s = 0; s < CAPTURE_SLOTS; s++){
+        free(captureSlots[s].pixels);
+    }
+    free(capturePlanes);
+    free(captureFlipped);
+    capturing = false;
+    printf("capture: %ld of %ld frames written to %s for %ld ticks, %ld dropped, %ld waits, queue depth %i at most\n",
+        atomic_load(&captureWritten), captureFrames, captureFileName, captureTicks, captureDropped, captureWaits, captureDepthMax);
+    if (captureReadbacks > 0){
+        printf("capture: %ld gpu readbacks on the main thread, %.3f ms mean %.3f ms worst\n",
+            captureReadbacks, captureReadbackTime * 1000 / captureReadbacks, captureReadbackWorst * 1000);
+    }
+}
+
+void drawCaptureStats(){
+    DrawText(TextFormat("CAPTURE %ld FRAMES %ld WRITTEN %ld DROPPED, QUEUE %i/%i, READBACK %.2f MS AVG %.2f MS WORST", captureFrames, atomic_load(&captureWritten), captureDropped, captureQueueDepth(), CAPTURE_SLOTS,
+        captureReadbacks > 0 ? captureReadbackTime * 1000 / captureReadbacks : 0, captureReadbackWorst * 1000),
+        10, GetScreenHeight() - 35, 10, captureDropped > 0 ? ORANGE : WHITE);
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Sprite loading *
+//------------------------------------------------------------------------------------
+
+
+
+// every sprite gets packed into a few big atlas pages at startup, so drawing
+// mostly reuses one bound texture instead of switching for every sprite
+#define SPRITE_PLAYER 0
+#define SPRITE_PLAYER_LEFT 1
+#define SPRITE_PLAYER_RIGHT 2
+#define SPRITE_BULLET 3
+#define SPRITE_ENEMY_BULLET 4
+#define SPRITE_POW 5
+#define SPRITE_SAMUEL 6
+#define SPRITE_LAMPIR 7
+#define SPRITE_MUD_BACKGROUND 8
+#define SPRITE_GRASS_BACKGROUND 9
+#define SPRITE_SAND_BACKGROUND 10
+#define SPRITE_EXPLOSION 11
+#define EXPLOSION_COUNT 7
+#define SPRITE_COUNT (SPRITE_EXPLOSION + EXPLOSION_COUNT)
+
+const char* spriteFiles[SPRITE_COUNT] = {
+    "sprites/player_0.png",
+    "sprites/player_1.png",
+    "sprites/player_2.png",
+    "sprites/bullet.png",
+    "sprites/enemy_bullet.png",
+    "sprites/pow.png",
+    "sprites/samuel.png",
+    "sprites/lampir.png",
+    "sprites/mudBack.png",
+    "sprites/grassBack.png",
+    "sprites/sandBack.png",
+    "sprites/sprite_3.png",
+    "sprites/sprite_4.png",
+    "sprites/sprite_5.png",
+    "sprites/sprite_6.png",
+    "sprites/sprite_0.png",
+    "sprites/sprite_1.png",
+    "sprites/sprite_2.png",
+};
+
+#define ATLAS_SIZE 1024
+#define ATLAS_PADDING 2
+#define MAX_ATLAS_PAGES 4
+
+struct AtlasSprite{
+    int page;
+    Rectangle source;
+};
+
+struct AtlasSprite atlasSprites[SPRITE_COUNT];
+Texture2D atlasPages[MAX_ATLAS_PAGES];
+int atlasPageCount = 0;
+
+// sound ids double as priorities, a higher id may cut off a lower one when voices run out
+#define SOUND_SHOOT_PLAYER 0
+#define SOUND_EXPLOSION 1
+#define SOUND_BONUS 2
+#define SOUND_GAME_OVER 3
+#define SOUND_COUNT 4
+
+const char* soundFiles[SOUND_COUNT] = {
+    "sounds/laser.wav",
+    "sounds/explosion.wav",
+    "sounds/bonus.wav",
+    "sounds/gameOver.wav",
+};
+
+Sound sounds[SOUND_COUNT];
+
+// the music streams from its own file instead of going through the pack (see * Audio
+// thread *), and the game plays on without it when the file isn't there
+#define MUSIC_FILE "sounds/hudba.mp3"
+
+RenderTexture2D renderTexture;
+
+// copies the pixels straight over, ImageDraw would blend them with the empty page
+void copyImagePixels(Image* page, Image* image, int x, int y){
+    unsigned char* dst = page->data;
+    unsigned char* src = image->data;
+    for (int row = 0; row < image->height; row++){
+        memcpy(dst + ((y + row) * page->width + x) * 4, src + row * image->width * 4, image->width * 4);
+    }
+}
+
+// shelf packing, tallest sprites first so every shelf wastes as little height as possible.
+// only touches memory so it can run on the loader thread, uploadAtlas turns the pages into textures
+Image atlasImages[MAX_ATLAS_PAGES];
+
+void buildAtlas(Image* images){
+    int order[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; i++){
+        order[i] = i;
+    }
+    for (int i = 1; i < SPRITE_COUNT; i++){
+        for (int j = i; j > 0 && images[order[j]].height > images[order[j - 1]].height; j--){
+            int swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+    
+    Image* pages = atlasImages;
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    atlasPageCount = 0;
+    
+    for (int n = 0; n < SPRITE_COUNT; n++){
+        int i = order[n];
+        int w = images[i].width + ATLAS_PADDING;
+        int h = images[i].height + ATLAS_PADDING;
+        
+        if (shelfX + w > ATLAS_SIZE){
+            shelfX = 0;
+            shelfY += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (atlasPageCount == 0 || shelfY + h > ATLAS_SIZE){
+            if (atlasPageCount == MAX_ATLAS_PAGES){
+                printf("atlas: out of pages for %s\n", spriteFiles[i]);
+                break;
+            }
+            pages[atlasPageCount++] = GenImageColor(ATLAS_SIZE, ATLAS_SIZE, BLANK);
+            shelfX = 0;
+            shelfY = 0;
+            shelfHeight = 0;
+        }
+        
+        copyImagePixels(&pages[atlasPageCount - 1], &images[i], shelfX, shelfY);
+        atlasSprites[i].page = atlasPageCount - 1;
+        atlasSprites[i].source = (Rectangle){ shelfX, shelfY, images[i].width, images[i].height };
+        shelfX += w;
+        shelfHeight = shelfHeight > h ? shelfHeight : h;
+    }
+}
+
+// the software renderer keeps sampling the pages on the cpu, so it keeps the images too
+void uploadAtlas(){
+    for (int p = 0; p < atlasPageCount; p++){
+        atlasPages[p] = LoadTextureFromImage(atlasImages[p]);
+        if (!softwareRender){
+            UnloadImage(atlasImages[p]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------
+// * Draw queue *
+//------------------------------------------------------------------------------------
+// draw functions only queue commands, flushDrawQueue sorts them by layer, then by
+// texture, then by submission order and hands them to raylib in one go. that keeps
+// z order fixed no matter where entities sit in their buckets and lets raylib
+// batch everything sharing a texture
+#define LAYER_BACKGROUND 0
+#define LAYER_ENEMIES 1
+#define LAYER_BULLETS 2
+#define LAYER_PLAYER 3
+#define LAYER_PARTICLES 4
+#define LAYER_HUD 5
+
+// text is drawn with the font texture, which sorts after every atlas page
+#define TEXTURE_FONT MAX_ATLAS_PAGES
+#define TEXTURE_HUD (MAX_ATLAS_PAGES + 1)
+#define DRAW_TEXT_SIZE 4096
+#define DRAW_TEXT -1
+#define DRAW_HUD_LAYER -2      // the cached hud, see * hud *
+
+struct DrawCommand{
+    long long key;
+    int sprite;         // or DRAW_TEXT, DRAW_HUD_LAYER
+    float x;
+    float y;
+    float scale;
+    Color tint;
+    int text;           // offset into drawQueueText
+    int fontSize;
+};
+
+struct DrawCommand* drawQueue = NULL;
+int drawQueueCount = 0;
+int drawQueueCapacity = 0;
+char drawQueueText[DRAW_TEXT_SIZE];
+int drawQueueTextUsed = 0;
+
+int frameDrawCalls = 0;
+int frameTextureSwitches = 0;
+bool showDrawStats = false;
+
+struct DrawCommand* queueDrawCommand(int layer, int texture){
+    if (drawQueueCount == drawQueueCapacity){
+        int capacity = drawQueueCapacity == 0 ? 256 : drawQueueCapacity * 2;
+        struct DrawCommand* grown = realloc(drawQueue, sizeof(struct DrawCommand) * capacity);
+        if (grown == NULL){
+            return NULL;
+        }
+        drawQueue = grown;
+        drawQueueCapacity = capacity;
+    }
+    
+    struct DrawCommand* command = &drawQueue[drawQueueCount];
+    command->key = ((long long)layer << 40) | ((long long)texture << 32) | drawQueueCount;
+    drawQueueCount++;
+    return command;
+}
+
+void drawSpriteScaled(int layer, int sprite, float x, float y, float scale, Color tint){
+    struct DrawCommand* command = queueDrawCommand(layer, atlasSprites[sprite].page);
+    if (command == NULL){
+        return;
+    }
+    command->sprite = sprite;
+    command->x = x;
+    command->y = y;
+    command->scale = scale;
+    command->tint = tint;
+}
+
+void drawSprite(int layer, int sprite, float x, float y, Color tint){
+    drawSpriteScaled(layer, sprite, x, y, 1.0f, tint);
+}
+
+// the simulation runs at a fixed rate and frames land somewhere between two ticks,
+// renderAlpha is how far past the last tick this frame is
+float renderAlpha = 1.0f;
+
+// anything that moved further than this in one tick teleported and is drawn where it is now
+#define MAX_INTERPOLATED_STEP 32
+
+float interpolate(float previous, float current){
+    if (fabsf(current - previous) > MAX_INTERPOLATED_STEP){
+        return current;
+    }
+    return previous + (current - previous) * renderAlpha;
+}
+
+void drawText(int layer, const char* text, int x, int y, int fontSize, Color color){
+    int length = strlen(text) + 1;
+    if (drawQueueTextUsed + length > DRAW_TEXT_SIZE){
+        return;
+    }
+    struct DrawCommand* command = queueDrawCommand(layer, TEXTURE_FONT);
+    if (command == NULL){
+        return;
+    }
+    memcpy(drawQueueText + drawQueueTextUsed, text, length);
+    command->sprite = DRAW_TEXT;
+    command->text = drawQueueTextUsed;
+    command->x = x;
+    command->y = y;
+    command->fontSize = fontSize;
+    command->tint = color;
+    drawQueueTextUsed += length;
+}
+
+void queueHudLayer(){
+    struct DrawCommand* command = queueDrawCommand(LAYER_HUD, TEXTURE_HUD);
+    if (command != NULL){
+        command->sprite = DRAW_HUD_LAYER;
+    }
+}
+
+int compareDrawCommands(const void* a, const void* b){
+    long long keyA = ((const struct DrawCommand*)a)->key;
+    long long keyB = ((const struct DrawCommand*)b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+void flushDrawQueue(){
+    qsort(drawQueue, drawQueueCount, sizeof(struct DrawCommand), compareDrawCommands);
+    
+    frameDrawCalls = 0;
+    frameTextureSwitches = 0;
+    int boundTexture = -1;
+    for (int i = 0; i < drawQueueCount; i++){
+        struct DrawCommand* command = &drawQueue[i];
+        int texture = (command->key >> 32) & 0xff;
+        if (texture != boundTexture){
+            frameTextureSwitches++;
+            boundTexture = texture;
+        }
+        frameDrawCalls++;
+        
+        if (command->sprite == DRAW_HUD_LAYER){
+            drawHudLayer();
+        }else if (command->sprite == DRAW_TEXT && softwareRender){
+            softwareDrawText(drawQueueText + command->text, command->x, command->y, command->fontSize, command->tint);
+        }else if (command->sprite == DRAW_TEXT){
+            DrawText(drawQueueText + command->text, command->x, command->y, command->fontSize, command->tint);
+        }else if (softwareRender){
+            struct AtlasSprite* s = &atlasSprites[command->sprite];
+            softwareDrawSprite(&atlasImages[s->page], s->source, command->x, command->y, command->scale, command->tint);
+        }else if (command->scale == 1.0f){
+            struct AtlasSprite* s = &atlasSprites[command->sprite];
+            Vector2 v = { command->x, command->y };
+            DrawTextureRec(atlasPages[s->page], s->source, v, command->tint);
+        }else {
+            struct AtlasSprite* s = &atlasSprites[command->sprite];
+            Rectangle dest = { command->x, command->y, s->source.width * command->scale, s->source.height * command->scale };
+            Vector2 origin = { 0, 0 };
+            DrawTexturePro(atlasPages[s->page], s->source, dest, origin, 0.0f, command->tint);
+        }
+    }
+    drawQueueCount = 0;
+    drawQueueTextUsed = 0;
+    
+    if (showDrawStats && softwareRender){
+        softwareDrawText(TextFormat("%i DRAWS", frameDrawCalls), 5, 330, 1, WHITE);
+    }else if (showDrawStats){
+        DrawText(TextFormat("%i DRAWS %i TEXTURE SWITCHES", frameDrawCalls, frameTextureSwitches), 5, 330, 1, WHITE);
+    }
+}
+
+//------------------------------------------------------------------------------------
+// * Asset pack *
+//------------------------------------------------------------------------------------
+// --pack-assets decodes every sprite and sound once and writes the raw RGBA pixels
+// and PCM samples into a single file behind an index. the game maps that file and
+// only has to pack the atlas on a loader thread while the loading screen runs.
+// without a pack it falls back to decoding the loose files on the same thread
+#define ASSET_PACK_FILE "assets.pak"
+#define PACK_MAGIC 0x4b415045           // "EPAK"
+#define PACK_VERSION 1
+#define PACK_NAME_SIZE 40
+#define PACK_ALIGNMENT 16
+#define PACK_IMAGE 0
+#define PACK_WAVE 1
+#define ASSET_COUNT (SPRITE_COUNT + SOUND_COUNT)
+
+struct PackHeader{
+    unsigned int magic;
+    int version;
+    int entryCount;
+    int reserved;
+};
+
+struct PackEntry{
+    char name[PACK_NAME_SIZE];
+    int type;
+    int width;                  // images
+    int height;
+    unsigned int frameCount;    // waves
+    unsigned int sampleRate;
+    unsigned int sampleSize;
+    unsigned int channels;
+    unsigned int offset;        // from the start of the file
+    unsigned int size;
+};
+
+const char* assetFile(int asset){
+    return asset < SPRITE_COUNT ? spriteFiles[asset] : soundFiles[asset - SPRITE_COUNT];
+}
+
+bool packAssets(const char* path){
+    int missing = 0;
+    for (int asset = 0; asset < ASSET_COUNT; asset++){
+        if (!FileExists(assetFile(asset))){
+            printf("assets: missing %s\n", assetFile(asset));
+            missing++;
+        }
+    }
+    if (missing > 0){
+        return false;
+    }
+    
+    FILE* file = fopen(path, "wb");
+    if (file == NULL){
+        printf("assets: can't open %s\n", path);
+        return false;
+    }
+    
+    struct PackHeader header = { PACK_MAGIC, PACK_VERSION, ASSET_COUNT, 0 };
+    struct PackEntry entries[ASSET_COUNT];
+    memset(entries, 0, sizeof(entries));
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries, sizeof(entries), 1, file);
+    
+    unsigned int offset = sizeof(header) + sizeof(entries);
+    for (int asset = 0; asset < ASSET_COUNT; asset++){
+        struct PackEntry* entry = &entries[asset];
+        strncpy(entry->name, assetFile(asset), PACK_NAME_SIZE - 1);
+        
+        Image image = { 0 };
+        Wave wave = { 0 };
+        void* data;
+        if (asset < SPRITE_COUNT){
+            image = LoadImage(assetFile(asset));
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            entry->type = PACK_IMAGE;
+            entry->width = image.width;
+            entry->height = image.height;
+            entry->size = image.width * image.height * 4;
+            data = image.data;
+        }else {
+            wave = LoadWave(assetFile(asset));
+            entry->type = PACK_WAVE;
+            entry->frameCount = wave.frameCount;
+            entry->sampleRate = wave.sampleRate;
+            entry->sampleSize = wave.sampleSize;
+            entry->channels = wave.channels;
+            entry->size = wave.frameCount * wave.channels * (wave.sampleSize / 8);
+            data = wave.data;
+        }
+        
+        // every blob starts aligned so the game can use it straight out of the mapping
+        while (offset % PACK_ALIGNMENT != 0){
+            fputc(0, file);
+            offset++;
+        }
+        entry->offset = offset;
+        fwrite(data, 1, entry->size, file);
+        offset += entry->size;
+        if (asset < SPRITE_COUNT){
+            UnloadImage(image);
+        }else {
+            UnloadWave(wave);
+        }
+    }
+    
+    fseek(file, sizeof(header), SEEK_SET);
+    fwrite(entries, sizeof(entries), 1, file);
+    fclose(file);
+    printf("assets: packed %i files into %s, %u bytes\n", ASSET_COUNT, path, offset);
+    return true;
+}
+
+unsigned char* packData = NULL;
+long packSize = 0;
+struct PackEntry* packEntries[ASSET_COUNT];
+
+Image assetImages[SPRITE_COUNT];
+Wave assetWaves[SOUND_COUNT];
+pthread_t assetLoader;
+atomic_int assetsDone = 0;         // how many assets the loader thread has finished
+atomic_bool assetsReady = false;
+double assetLoadTime = 0;
+
+void unmapAssetPack(){
+    if (packData == NULL){
+        return;
+    }
+#if defined(_WIN32)
+    free(packData);
+#else
+    munmap(packData, packSize);
+#endif
+    packData = NULL;
+}
+
+bool mapAssetPack(const char* path){
+#if defined(_WIN32)
+    FILE* file = fopen(path, "rb");
+    if (file == NULL){
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    packSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    packData = malloc(packSize);
+    if (packData == NULL || fread(packData, 1, packSize, file) != (size_t)packSize){
+        free(packData);
+        packData = NULL;
+    }
+    fclose(file);
+#else
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0){
+        return false;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0){
+        packSize = info.st_size;
+        packData = mmap(NULL, packSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (packData == MAP_FAILED){
+            packData = NULL;
+        }
+    }
+    close(descriptor);
+#endif
+    return packData != NULL;
+}
+
+// finds every asset in the pack index, anything missing or cut off is reported before loading starts
+bool indexAssetPack(){
+    struct PackHeader* header = (struct PackHeader*)packData;
+    if (packSize < (long)sizeof(struct PackHeader) || header->magic != PACK_MAGIC || header->version != PACK_VERSION ||
+        packSize < (long)(sizeof(struct PackHeader) + header->entryCount * sizeof(struct PackEntry))){
+        printf("assets: %s is not a version %i pack, run make assets\n", ASSET_PACK_FILE, PACK_VERSION);
+        return false;
+    }
+    
+    struct PackEntry* entries = (struct PackEntry*)(packData + sizeof(struct PackHeader));
+    int missing = 0;
+    for (int asset = 0; asset < ASSET_COUNT; asset++){
+        packEntries[asset] = NULL;
+        for (int e = 0; e < header->entryCount; e++){
+            if (strncmp(entries[e].name, assetFile(asset), PACK_NAME_SIZE) == 0 && (long)entries[e].offset + entries[e].size <= packSize){
+                packEntries[asset] = &entries[e];
+            }
+        }
+        if (packEntries[asset] == NULL){
+            printf("assets: %s has no %s\n", ASSET_PACK_FILE, assetFile(asset));
+            missing++;
+        }
+    }
+    return missing == 0;
+}
+
+void* assetLoaderMain(void* argument){
+    double start = getTimeSeconds();
+    for (int asset = 0; asset < ASSET_COUNT; asset++){
+        struct PackEntry* entry = packEntries[asset];
+        if (asset < SPRITE_COUNT){
+            Image* image = &assetImages[asset];
+            if (packData != NULL){
+                // straight out of the mapping, buildAtlas copies the pixels before it goes away
+                *image = (Image){ packData + entry->offset, entry->width, entry->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+            }else {
+                *image = LoadImage(assetFile(asset));
+                ImageFormat(image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            }
+        }else {
+            Wave* wave = &assetWaves[asset - SPRITE_COUNT];
+            if (packData != NULL){
+                *wave = (Wave){ entry->frameCount, entry->sampleRate, entry->sampleSize, entry->channels, packData + entry->offset };
+            }else {
+                *wave = LoadWave(assetFile(asset));
+            }
+        }
+        atomic_fetch_add(&assetsDone, 1);
+    }
+    
+    buildAtlas(assetImages);
+    assetLoadTime = getTimeSeconds() - start;
+    atomic_store(&assetsReady, true);
+    return NULL;
+}
+
+// maps the pack, or checks the loose files when there is none, and starts the loader thread
+bool startLoadingAssets(){
+    if (mapAssetPack(ASSET_PACK_FILE)){
+        if (!indexAssetPack()){
+            unmapAssetPack();
+            return false;
+        }
+        printf("assets: mapped %s, %ld bytes\n", ASSET_PACK_FILE, packSize);
+    }else {
+        printf("assets: no %s, decoding the loose files\n", ASSET_PACK_FILE);
+        int missing = 0;
+        for (int asset = 0; asset < ASSET_COUNT; asset++){
+            if (!FileExists(assetFile(asset))){
+                printf("assets: missing %s\n", assetFile(asset));
+                missing++;
+            }
+        }
+        if (missing > 0){
+            return false;
+        }
+    }
+    
+    if (pthread_create(&assetLoader, NULL, assetLoaderMain, NULL) != 0){
+        assetLoaderMain(NULL);
+        assetLoader = pthread_self();
+    }
+    return true;
+}
+
+void joinAssetLoader(){
+    if (!pthread_equal(assetLoader, pthread_self())){
+        pthread_join(assetLoader, NULL);
+    }
+}
+
+// the mapping or the decoded files, the atlas and the sounds have their own copies by now
+void releaseAssetSources(){
+    if (packData != NULL){
+        unmapAssetPack();
+    }else {
+        for (int i = 0; i < SPRITE_COUNT; i++){
+            UnloadImage(assetImages[i]);
+        }
+        for (int i = 0; i < SOUND_COUNT; i++){
+            UnloadWave(assetWaves[i]);
+        }
+    }
+}
+
+Texture2D softwareTexture;
+
+// gpu frames are read back from a ring of render targets. the one read is the one drawn
+// CAPTURE_TARGETS - 1 frames ago, the gpu is long done with it so the read doesn't wait
+// for the frame that was just queued. the copy itself still happens on the main thread,
+// LoadImageFromTexture reads the pixels back synchronously, so what it costs is timed
+// and reported with the other capture stats
+#define CAPTURE_TARGETS 3
+
+RenderTexture2D captureTargets[CAPTURE_TARGETS];
+int captureTargetTicks[CAPTURE_TARGETS];
+int captureTargetCount = 0;        // 0 unless a windowed gpu run is capturing
+long captureTargetFrame = 0;
+
+// after frame f is presented frame f - 2 is read back, and frame f + 1 goes into the target it was in
+void readBackCaptureTarget(int ticks){
+    long frame = captureTargetFrame++;
+    captureTargetTicks[frame % CAPTURE_TARGETS] = ticks;
+    if (frame >= CAPTURE_TARGETS - 1){
+        int target = (frame + 1) % CAPTURE_TARGETS;
+        if (captureTargetTicks[target] > 0 || captureOwedTicks > 0){
+            double start = getTimeSeconds();
+            Image image = LoadImageFromTexture(captureTargets[target].texture);
+            captureFrame(image.data, true, captureTargetTicks[target]);
+            UnloadImage(image);
+            double spent = getTimeSeconds() - start;
+            captureReadbacks++;
+            captureReadbackTime += spent;
+            captureReadbackWorst = spent > captureReadbackWorst ? spent : captureReadbackWorst;
+        }
+    }
+    renderTexture = captureTargets[captureTargetFrame % CAPTURE_TARGETS];
+}
+
+
+// everything that needs the gl context or the audio device happens back on the main thread
+void finishLoadingAssets(){
+    joinAssetLoader();
+    uploadAtlas();
+    
+    for (int i = 0; i < SOUND_COUNT; i++){
+        sounds[i] = LoadSoundFromWave(assetWaves[i]);
+    }
+    loadVoices();
+    releaseAssetSources();
+    
+    // render texture
+    if (capturing && !softwareRender){
+        for (int t = 0; t < CAPTURE_TARGETS; t++){
+            captureTargets[t] = LoadRenderTexture(screenWidth, screenHeight);
+        }
+        captureTargetCount = CAPTURE_TARGETS;
+        renderTexture = captureTargets[0];
+    }else {
+        renderTexture = LoadRenderTexture(screenWidth, screenHeight);
+    }
+    if (softwareRender){
+        softwareTexture = LoadTextureFromImage((Image){ framebuffer, screenWidth, screenHeight, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 });
+    }
+}
+
+// headless runs have no gl context or audio device, they only need the atlas pages as images
+bool loadSoftwareAssets(){
+    if (!startLoadingAssets()){
+        return false;
+    }
+    joinAssetLoader();
+    releaseAssetSources();
+    return true;
+}
+
+void drawLoadingScreen(){
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    float progress = atomic_load(&assetsDone) / (float)ASSET_COUNT;
+    DrawText("NACITANI", width / 2 - MeasureText("NACITANI", 20) / 2, height / 2 - 30, 20, WHITE);
+    DrawRectangleLines(width / 2 - 100, height / 2, 200, 10, WHITE);
+    DrawRectangle(width / 2 - 100, height / 2, (int)(200 * progress), 10, WHITE);
+}
+
+void unloadSprites(){
+    for (int i = 0; i < atlasPageCount; i++){
+        UnloadTexture(atlasPages[i]);
+    }
+    
+    // sounds
+    stopAudioThread();
+    unloadVoices();
+    for (int i = 0; i < SOUND_COUNT; i++){
+        UnloadSound(sounds[i]);
+    }
+    
+    // render texture
+    if (captureTargetCount > 0){
+        for (int t = 0; t < captureTargetCount; t++){
+            UnloadRenderTexture(captureTargets[t]);
+        }
+    }else {
+        UnloadRenderTexture(renderTexture);
+    }
+    if (softwareRender){
+        UnloadTexture(softwareTexture);
+    }
+    unloadHud();
+}
+
+void unloadSoftwareAssets(){
+    if (!softwareRender){
+        return;
+    }
+    for (int i = 0; i < atlasPageCount; i++){
+        UnloadImage(atlasImages[i]);
+    }
+}
+
+//------------------------------------------------------------------------------------
+// * Game world *
+//------------------------------------------------------------------------------------
+// everything one game owns, so a process can run as many games side by side as it
+// likes. the simulation and the drawing only ever reach a game through the world they
+// are handed, what is left at file scope belongs to the process: the window, assets,
+// audio device, worker threads and tools. the types the world is made of live here
+// with it, their functions stay in their own sections
+#define MAX_PLAYERS 2               // the second slot only gets used by netplay
+#define MAX_ENTITIES 16384
+#define MAX_PARTICLES 8192          // power of two, slots are n & (MAX_PARTICLES - 1)
+#define MAX_EMITTERS 64
+#define AI_COUNT 6                  // updateEnemyManagement rolls up to 5, which never had a constant of its own
+#define MASK_WORDS(count) (((count) + 31) / 32)
+#define GRID_CELL_SIZE 32
+#define GRID_COLUMNS 8
+#define GRID_ROWS 11
+#define GRID_CELLS (GRID_ROWS * GRID_COLUMNS)
+
+struct Player{
+    int x;
+    int y;
+    int fireRate;
+    int fireCooldown;
+    int projectileCount;
+    int invinciblity;
+    int deadTimer;
+    int direction;
+    int previousX;      // position before the last tick, only used for drawing
+    int previousY;
+};
+
+// every kind of entity lives in its own dense bucket stored as separate arrays, see * entities *
+struct Entities{
+    int count;
+    int capacity;
+    int* x;
+    int* y;
+    int* width;
+    int* height;
+    int* health;
+    int* timer;
+    int* steer;         // direction an enemy drifts towards the player in
+    int* steerDelay;    // ticks between two steering steps
+    int* hitFlash;
+    int* enemyType;
+    int* ai;
+    int* seed;          // the entity's own random state
+    int* previousX;     // position before the last tick, only used for drawing
+    int* previousY;
+};
+
+// see * Particles *
+struct Particles{
+    unsigned int head;      // oldest particle, counts up forever like tail
+    unsigned int tail;
+    int x[MAX_PARTICLES];
+    int y[MAX_PARTICLES];
+    int previousY[MAX_PARTICLES];
+    int age[MAX_PARTICLES];
+    int lifetime[MAX_PARTICLES];
+    int sprite[MAX_PARTICLES];
+    int firstSprite[MAX_PARTICLES];
+    int frameStep[MAX_PARTICLES];
+    int kind[MAX_PARTICLES];
+};
+
+struct Emitter{
+    int x;
+    int y;
+    int timer;
+};
+
+#define COMMAND_SPAWN_BULLET 0      // a = x, b = y, c = team
+#define COMMAND_KILL_ENEMY 1        // a = enemy
+#define COMMAND_REMOVE_ENEMY 2      // a = enemy
+#define COMMAND_HIT_ENEMY 3         // a = player bullet, b = enemy
+
+struct Command{
+    int type;
+    int a;
+    int b;
+    int c;
+};
+
+// aligned so two workers never write to the same cache line
+struct CommandBuffer{
+    _Alignas(64) struct Command* commands;
+    int count;
+    int capacity;
+    long pairTests;
+};
+
+struct GameWorld{
+    unsigned int randomState;   // everything the game rolls comes from here, seeded so runs can be replayed
+    int playerCount;
+    struct Player players[MAX_PLAYERS];
+    int playerX[MAX_PLAYERS];   // where each player last stood alive, samuel steers for it
+    int playerY[MAX_PLAYERS];
+    int playerLevel;
+    int playerLives;
+    int killedThisLife;
+    int enemiesKilled;
+    int enemySpawnTimer;
+    int upgradeTimer;
+    float backgroundSpeed;
+    float backgroundOffset;
+    float previousBackgroundOffset;
+    int currentBackground;
+    int movedBackgrounds;
+    int fadeTimer;
+    
+    struct Entities playerBullets;
+    struct Entities enemyBullets;
+    struct Entities enemies;
+    struct Particles particles;
+    struct Emitter emitters[MAX_EMITTERS];      // packed into [0, emitterCount) like the buckets
+    int emitterCount;
+    
+    bool audible;               // off for batch games and while a rollback replays ticks that already made their sounds
+    int soundRequests[SOUND_COUNT];
+    
+    // what a tick works in, kept here so games on different threads never share any
+    struct CommandBuffer commandBuffers[MAX_WORKERS];
+    int enemyOrder[MAX_ENTITIES];       // live enemy indices sorted by ai, group g is enemyOrder[aiGroupStart[g] .. aiGroupStart[g + 1])
+    int aiGroupStart[AI_COUNT + 1];
+    int removedEnemies[MAX_ENTITIES];
+    int gridCellStart[GRID_CELLS + 1];
+    int gridCellOf[MAX_ENTITIES];
+    int binnedX[MAX_ENTITIES];
+    int binnedY[MAX_ENTITIES];
+    int binnedWidth[MAX_ENTITIES];
+    int binnedHeight[MAX_ENTITIES];
+    int binnedIndex[MAX_ENTITIES];
+    bool bulletUsed[MAX_ENTITIES];
+    unsigned int collisionMask[MAX_WORKERS][MASK_WORDS(MAX_ENTITIES)];
+    
+    long droppedSpawns;
+    long particlesOverwritten;
+    long collisionPairTests;
+};
+
+void seedRandom(struct GameWorld* world, unsigned int seed){
+    world->randomState = seed != 0 ? seed : 1;
+}
+
+int gameRandom(struct GameWorld* world, int min, int max){
+    return randomFrom(&world->randomState, min, max);
+}
+
+void pushCommand(struct GameWorld* world, int worker, int type, int a, int b, int c){
+    struct CommandBuffer* buffer = &world->commandBuffers[worker];
+    if (buffer->count == buffer->capacity){
+        int capacity = buffer->capacity == 0 ? 256 : buffer->capacity * 2;
+        struct Command* grown = realloc(buffer->commands, sizeof(struct Command) * capacity);
+        if (grown == NULL){
+            return;
+        }
+        buffer->commands = grown;
+        buffer->capacity = capacity;
+    }
+    
+    struct Command* command = &buffer->commands[buffer->count++];
+    command->type = type;
+    command->a = a;
+    command->b = b;
+    command->c = c;
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Quality governor *
+//------------------------------------------------------------------------------------
+// a lampir's big explosion piles particles and sounds on exactly the frames that are
+// already busiest. the governor watches how long the windowed loop works on a frame,
+// everything but the wait in EndDrawing, and when the average over a window goes over
+// the budget it steps down a level. after QUALITY_RECOVER_FRAMES frames comfortably
+// under budget it steps back up. the levels only thin out what gets drawn and heard,
+// the particles themselves stay in the world, so checksums, snapshots and netplay
+// never see the governor. that includes the explosions a big explosion's emitter
+// spawns: they are world state (hashed, snapshotted, rolled back, placed with the
+// world's random rolls), so spawning fewer on a slow machine would desync a netplay
+// peer and break replays. they get thinned when they are drawn instead
+#define QUALITY_WINDOW 30
+#define QUALITY_RECOVER_FRAMES 120
+#define QUALITY_RECOVER_SHARE 0.6f      // of the budget a frame has to stay under to count towards recovering
+
+struct QualityLevel{
+    const char* name;
+    int explosionStride;    // every nth explosion particle gets drawn, all of them are still spawned
+    bool pows;
+    int soundsPerTick;      // voices flushSounds may start in one tick, highest priority first
+    int maxVoices;          // playing at once, replaces MAX_ACTIVE_VOICES
+};
+
+const struct QualityLevel qualityLevels[] = {
+    { "full", 1, true, SOUND_COUNT, 8 },
+    { "fewer explosions", 2, true, 2, 6 },
+    { "no pows", 3, false, 2, 4 },
+    { "minimal", 4, false, 1, 3 },
+};
+#define QUALITY_LEVEL_COUNT (int)(sizeof(qualityLevels) / sizeof(qualityLevels[0]))
+
+float frameBudget = 12.0f;      // ms, 0 turns the governor off
+int qualityLevel = 0;
+long long qualityFrameStart = 0;
+float qualityWindowSum = 0;
+int qualityWindowFrames = 0;
+int qualityCalmFrames = 0;
+float qualityLastAverage = 0;
+long qualityChanges = 0;
+long explosionsShed = 0;         // particles, counted once however many frames they stay hidden
+long powsShed = 0;
+long soundsShed = 0;
+
+void qualityFrameBegin(){
+    qualityFrameStart = getTimeNanos();
+}
+
+void setQualityLevel(int level, float average){
+    printf("quality: %s, frames took %.2f ms against a %.2f ms budget\n", qualityLevels[level].name, average, frameBudget);
+    qualityLevel = level;
+    qualityChanges++;
+    qualityWindowSum = 0;
+    qualityWindowFrames = 0;
+    qualityCalmFrames = 0;
+}
+
+// call before EndDrawing, so waiting on vsync never counts as work
+void qualityFrameEnd(){
+    if (frameBudget <= 0){
+        return;
+    }
+    float work = (getTimeNanos() - qualityFrameStart) / 1000000.0f;
+    qualityWindowSum += work;
+    qualityWindowFrames++;
+    qualityCalmFrames = work < frameBudget * QUALITY_RECOVER_SHARE ? qualityCalmFrames + 1 : 0;
+    
+    if (qualityWindowFrames == QUALITY_WINDOW){
+        qualityLastAverage = qualityWindowSum / QUALITY_WINDOW;
+        qualityWindowSum = 0;
+        qualityWindowFrames = 0;
+        if (qualityLastAverage > frameBudget && qualityLevel < QUALITY_LEVEL_COUNT - 1){
+            setQualityLevel(qualityLevel + 1, qualityLastAverage);
+            return;
+        }
+    }
+    if (qualityCalmFrames >= QUALITY_RECOVER_FRAMES && qualityLevel > 0){
+        setQualityLevel(qualityLevel - 1, qualityLastAverage);
+    }
+}
+
+// drawn on the screen with the other stats (F2)
+void drawQualityStats(){
+    DrawText(TextFormat("QUALITY %s, %.2f MS OF %.2f, SHED %ld EXPLOSIONS %ld POWS %ld SOUNDS",
+        qualityLevels[qualityLevel].name, qualityLastAverage, frameBudget, explosionsShed, powsShed, soundsShed),
+        10, GetScreenHeight() - 65, 10, qualityLevel > 0 ? ORANGE : WHITE);
+}
+
+void printQualityStats(){
+    printf("quality: ended on %s after %ld changes, shed %ld explosions, %ld pows, %ld sounds\n",
+        qualityLevels[qualityLevel].name, qualityChanges, explosionsShed, powsShed, soundsShed);
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Sound voices *
+//------------------------------------------------------------------------------------
+// every sound gets a few aliases that can play over each other. playSound only marks
+// the sound for this tick, so forty explosions in one tick start a single voice when
+// flushSounds runs at the end of it. the voices themselves belong to the audio thread
+// (see below): with the quality level's maxVoices playing, a new sound cuts off the
+// oldest voice of the lowest priority below it, or gets dropped
+#define MAX_VOICES_PER_SOUND 6
+
+const int soundVoiceCount[SOUND_COUNT] = { 4, 6, 2, 1 };
+
+struct Voice{
+    Sound sound;
+    long started;       // soundTick it last started on, the oldest voice goes first
+};
+
+struct Voice voices[SOUND_COUNT][MAX_VOICES_PER_SOUND];
+atomic_bool voicesLoaded = false;     // the audio thread is already running when they load
+long soundTick = 0;
+long soundsTriggered = 0;
+long soundsMerged = 0;
+atomic_long soundsDropped = 0;
+atomic_long soundsStolen = 0;
+atomic_int voicesPlaying = 0;      // the audio thread counts them, the stats only read it
+
+void loadVoices(){
+    for (int sound = 0; sound < SOUND_COUNT; sound++){
+        for (int v = 0; v < soundVoiceCount[sound]; v++){
+            voices[sound][v].sound = LoadSoundAlias(sounds[sound]);
+            voices[sound][v].started = 0;
+        }
+    }
+    atomic_store_explicit(&voicesLoaded, true, memory_order_release);
+}
+
+void unloadVoices(){
+    if (!voicesLoaded){
+        return;
+    }
+    for (int sound = 0; sound < SOUND_COUNT; sound++){
+        for (int v = 0; v < soundVoiceCount[sound]; v++){
+            UnloadSoundAlias(voices[sound][v].sound);
+        }
+    }
+    atomic_store(&voicesLoaded, false);
+}
+
+// a world that isn't audible never reaches the voices or their counters, so games on other threads can't race them
+void playSound(struct GameWorld* world, int sound){
+    if (!world->audible){
+        return;
+    }
+    soundsTriggered++;
+    if (world->soundRequests[sound] > 0){
+        soundsMerged++;
+    }
+    world->soundRequests[sound]++;
+}
+
+int activeVoices(){
+    int active = 0;
+    for (int sound = 0; sound < SOUND_COUNT; sound++){
+        for (int v = 0; v < soundVoiceCount[sound]; v++){
+            active += IsSoundPlaying(voices[sound][v].sound);
+        }
+    }
+    return active;
+}
+
+// the oldest playing voice of the lowest priority up to maxPriority, NULL when there is none
+struct Voice* findVictim(int maxPriority){
+    for (int sound = 0; sound <= maxPriority; sound++){
+        struct Voice* oldest = NULL;
+        for (int v = 0; v < soundVoiceCount[sound]; v++){
+            struct Voice* voice = &voices[sound][v];
+            if (IsSoundPlaying(voice->sound) && (oldest == NULL || voice->started < oldest->started)){
+                oldest = voice;
+            }
+        }
+        if (oldest != NULL){
+            return oldest;
+        }
+    }
+    return NULL;
+}
+
+// audio thread only
+void startVoice(int sound, int maxVoices, long tick){
+    struct Voice* voice = NULL;
+    struct Voice* oldest = NULL;
+    for (int v = 0; v < soundVoiceCount[sound]; v++){
+        struct Voice* candidate = &voices[sound][v];
+        if (!IsSoundPlaying(candidate->sound)){
+            voice = candidate;
+            break;
+        }
+        if (oldest == NULL || candidate->started < oldest->started){
+            oldest = candidate;
+        }
+    }
+    
+    if (voice == NULL){
+        // every voice of this sound is busy, restarting the oldest keeps the voice count the same
+        voice = oldest;
+        atomic_fetch_add(&soundsStolen, 1);
+    }else if (activeVoices() >= maxVoices){
+        struct Voice* victim = findVictim(sound);
+        if (victim == NULL){
+            atomic_fetch_add(&soundsDropped, 1);
+            return;
+        }
+        StopSound(victim->sound);
+        atomic_fetch_add(&soundsStolen, 1);
+    }
+    
+    PlaySound(voice->sound);
+    voice->started = tick;
+}
+
+// drawn on the screen next to the draw stats
+void drawSoundStats(){
+    DrawText(TextFormat("SOUNDS %ld TRIGGERED %ld MERGED %ld STOLEN %ld DROPPED, %i VOICES",
+        soundsTriggered, soundsMerged, atomic_load(&soundsStolen), atomic_load(&soundsDropped), atomic_load(&voicesPlaying)), 10, GetScreenHeight() - 20, 10, WHITE);
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Audio thread *
+//------------------------------------------------------------------------------------
+// everything the game does with the audio device after startup happens on this thread.
+// sound effects reach it through a queue of commands: flushSounds writes one per sound
+// that starts this tick at the tail and wakes the thread, which picks them up at the
+// head and does the voice bookkeeping (finding a free alias, stealing one, stopping and
+// starting them). a full queue drops the sound, the game never waits on audio.
+// the music is decoded here as well and streamed through a ring of pcm frames: this
+// thread tops it up, raylib's device thread drains it from pullMusic. both rings have
+// a single writer and a single reader, so neither takes a lock. a pull the ring can't
+// cover plays silence and counts as an underrun. a bigger ring survives longer stalls
+// of this thread, --music-ring trades that against memory. how often it refills follows
+// from its size
+#define AUDIO_QUEUE_SIZE 64                 // power of two
+#define AUDIO_LATENCY_SAMPLES 1024
+#define AUDIO_IDLE_WAKE_MS 100              // with no music, only to keep the voice count on the stats fresh
+#define MUSIC_SAMPLE_RATE 44100
+#define MUSIC_CHANNELS 2
+#define MUSIC_RING_MAX_FRAMES 65536         // power of two
+#define MUSIC_REFILL_SHARE 4                // the ring gets topped up every 1/4 of the time it holds
+
+struct SoundCommand{
+    int sound;
+    int maxVoices;          // the quality level's, read on the game thread
+    long tick;              // soundTick of the flush, the age voices go by
+    unsigned int sequence;
+    long long queued;       // getTimeNanos when it went into the queue
+};
+
+struct SoundCommand audioQueue[AUDIO_QUEUE_SIZE];
+atomic_uint audioHead = 0;
+atomic_uint audioTail = 0;
+atomic_bool audioQuit = false;
+bool audioRunning = false;
+pthread_t audioThread;
+pthread_mutex_t audioLock = PTHREAD_MUTEX_INITIALIZER;     // only guards the sleep, not the queue
+pthread_cond_t audioWake = PTHREAD_COND_INITIALIZER;
+
+// game thread only
+unsigned int audioSequence = 0;
+long audioOverruns = 0;
+int audioDepthMax = 0;
+
+// audio thread only until it has been joined
+float audioLatencies[AUDIO_LATENCY_SAMPLES];   // ms from queued to started, a ring once it is full
+long audioLatencyCount = 0;
+atomic_long audioStarted = 0;
+atomic_long audioOutOfOrder = 0;
+
+// music. the ring counts frames, head is the device thread's and tail this thread's
+const char* musicPath = NULL;      // decoded by the audio thread when it starts
+Wave musicWave;                     // the decoded track, 16 bit stereo at MUSIC_SAMPLE_RATE
+unsigned int musicCursor = 0;       // next frame of the track to go into the ring
+AudioStream musicStream;
+bool musicDevice = false;
+int musicRingFrames = 8192;         // power of two, about 190 ms
+short musicRing[MUSIC_RING_MAX_FRAMES * MUSIC_CHANNELS];
+atomic_uint musicHead = 0;
+atomic_uint musicTail = 0;
+atomic_bool musicStreaming = false;
+long musicRefills = 0;
+// written by the device thread
+atomic_long musicPulls = 0;
+atomic_long musicUnderruns = 0;         // pulls that came up short
+atomic_long musicMissingFrames = 0;     // played as silence
+atomic_llong musicFillSum = 0;          // frames in the ring when a pull came, for the average
+atomic_int musicFillLow = MUSIC_RING_MAX_FRAMES;
+
+int audioQueueDepth(){
+    return atomic_load(&audioTail) - atomic_load(&audioHead);
+}
+
+int musicFill(){
+    return atomic_load(&musicTail) - atomic_load(&musicHead);
+}
+
+// false when the queue is full. the thread only looks once wakeAudioThread is called
+bool queueSound(int sound, int maxVoices){
+    unsigned int tail = atomic_load_explicit(&audioTail, memory_order_relaxed);
+    int depth = tail - atomic_load_explicit(&audioHead, memory_order_acquire);
+    if (depth == AUDIO_QUEUE_SIZE){
+        return false;
+    }
+    
+    struct SoundCommand* command = &audioQueue[tail % AUDIO_QUEUE_SIZE];
+    command->sound = sound;
+    command->maxVoices = maxVoices;
+    command->tick = soundTick;
+    command->sequence = audioSequence++;
+    command->queued = getTimeNanos();
+    atomic_store_explicit(&audioTail, tail + 1, memory_order_release);
+    audioDepthMax = depth + 1 > audioDepthMax ? depth + 1 : audioDepthMax;
+    return true;
+}
+
+// the thread checks the queue under the lock before it sleeps, so a wake can't slip in between
+void wakeAudioThread(){
+    pthread_mutex_lock(&audioLock);
+    pthread_cond_signal(&audioWake);
+    pthread_mutex_unlock(&audioLock);
+}
+
+void runSoundCommands(unsigned int* expected){
+    while (true){
+        unsigned int head = atomic_load_explicit(&audioHead, memory_order_relaxed);
+        if (head == atomic_load_explicit(&audioTail, memory_order_acquire)){
+            return;
+        }
+        struct SoundCommand command = audioQueue[head % AUDIO_QUEUE_SIZE];
+        atomic_store_explicit(&audioHead, head + 1, memory_order_release);
+        if (command.sequence != *expected){
+            atomic_fetch_add(&audioOutOfOrder, 1);
+        }
+        *expected = command.sequence + 1;
+        if (atomic_load_explicit(&voicesLoaded, memory_order_acquire)){
+            startVoice(command.sound, command.maxVoices, command.tick);
+        }
+        audioLatencies[audioLatencyCount++ % AUDIO_LATENCY_SAMPLES] = (getTimeNanos() - command.queued) / 1000000.0f;
+        atomic_fetch_add(&audioStarted, 1);
+    }
+}
+
+// tops the ring up from the track, which loops
+void refillMusic(){
+    unsigned int tail = atomic_load_explicit(&musicTail, memory_order_relaxed);
+    int space = musicRingFrames - (int)(tail - atomic_load_explicit(&musicHead, memory_order_acquire));
+    if (space == 0){
+        return;
+    }
+    const short* track = musicWave.data;
+    while (space > 0){
+        int slot = tail & (musicRingFrames - 1);
+        int frames = min(min(space, musicRingFrames - slot), musicWave.frameCount - musicCursor);
+        memcpy(musicRing + slot * MUSIC_CHANNELS, track + musicCursor * MUSIC_CHANNELS, sizeof(short) * MUSIC_CHANNELS * frames);
+        tail += frames;
+        space -= frames;
+        musicCursor = (musicCursor + frames) % musicWave.frameCount;
+    }
+    atomic_store_explicit(&musicTail, tail, memory_order_release);
+    musicRefills++;
+}
+
+// raylib calls this on its device thread whenever the stream wants more frames. it never
+// waits on the audio thread, whatever the ring can't cover is played as silence
+void pullMusic(void* buffer, unsigned int frames){
+    short* out = buffer;
+    if (!atomic_load_explicit(&musicStreaming, memory_order_acquire)){
+        memset(out, 0, sizeof(short) * MUSIC_CHANNELS * frames);
+        return;
+    }
+    unsigned int head = atomic_load_explicit(&musicHead, memory_order_relaxed);
+    unsigned int available = atomic_load_explicit(&musicTail, memory_order_acquire) - head;
+    atomic_fetch_add_explicit(&musicPulls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&musicFillSum, available, memory_order_relaxed);
+    if ((int)available < atomic_load_explicit(&musicFillLow, memory_order_relaxed)){
+        atomic_store_explicit(&musicFillLow, available, memory_order_relaxed);
+    }
+    
+    unsigned int copied = available < frames ? available : frames;
+    for (unsigned int n = 0; n < copied; ){
+        int slot = head & (musicRingFrames - 1);
+        int chunk = min(copied - n, musicRingFrames - slot);
+        memcpy(out + n * MUSIC_CHANNELS, musicRing + slot * MUSIC_CHANNELS, sizeof(short) * MUSIC_CHANNELS * chunk);
+        n += chunk;
+        head += chunk;
+    }
+    atomic_store_explicit(&musicHead, head, memory_order_release);
+    if (copied < frames){
+        memset(out + copied * MUSIC_CHANNELS, 0, sizeof(short) * MUSIC_CHANNELS * (frames - copied));
+        atomic_fetch_add_explicit(&musicUnderruns, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&musicMissingFrames, frames - copied, memory_order_relaxed);
+    }
+}
+
+void decodeMusic(){
+    if (musicPath != NULL && musicWave.frameCount == 0){
+        double start = getTimeSeconds();
+        Wave wave = LoadWave(musicPath);
+        if (wave.frameCount > 0){
+            WaveFormat(&wave, MUSIC_SAMPLE_RATE, 16, MUSIC_CHANNELS);
+            musicWave = wave;
+            printf("audio: decoded %s, %.1f s of music in %.0f ms\n", musicPath, wave.frameCount / (float)MUSIC_SAMPLE_RATE, (getTimeSeconds() - start) * 1000);
+        }else {
+            printf("audio: can't decode %s, playing without music\n", musicPath);
+        }
+    }
+    if (musicWave.frameCount > 0){
+        refillMusic();
+        atomic_store_explicit(&musicStreaming, true, memory_order_release);
+    }
+}
+
+void* audioThreadMain(void* argument){
+    unsigned int expected = 0;
+    decodeMusic();
+    bool streaming = atomic_load(&musicStreaming);
+    long waitNanos = streaming ? 1000000000LL * musicRingFrames / MUSIC_SAMPLE_RATE / MUSIC_REFILL_SHARE : AUDIO_IDLE_WAKE_MS * 1000000LL;
+    while (true){
+        runSoundCommands(&expected);
+        if (streaming){
+            refillMusic();
+        }
+        if (atomic_load_explicit(&voicesLoaded, memory_order_acquire)){
+            atomic_store(&voicesPlaying, activeVoices());
+        }
+        
+        pthread_mutex_lock(&audioLock);
+        if (audioQueueDepth() == 0 && !atomic_load(&audioQuit)){
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += waitNanos;
+            until.tv_sec += until.tv_nsec / 1000000000L;
+            until.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&audioWake, &audioLock, &until);
+        }
+        pthread_mutex_unlock(&audioLock);
+        // whatever is still queued gets started before the thread ends
+        if (atomic_load(&audioQuit) && audioQueueDepth() == 0){
+            break;
+        }
+    }
+    return NULL;
+}
+
+// starts before the assets are in, so the music decodes behind the loading screen. the
+// voices join in once loadVoices is done. audioRunning stays false when it can't start,
+// flushSounds then drops every sound
+void startAudioThread(){
+    if (!headless && FileExists(MUSIC_FILE)){
+        musicPath = MUSIC_FILE;
+        musicStream = LoadAudioStream(MUSIC_SAMPLE_RATE, 16, MUSIC_CHANNELS);
+        SetAudioStreamCallback(musicStream, pullMusic);
+        PlayAudioStream(musicStream);
+        musicDevice = true;
+    }else if (!headless){
+        printf("assets: no %s, playing without music\n", MUSIC_FILE);
+    }
+    atomic_store(&audioQuit, false);
+    if (pthread_create(&audioThread, NULL, audioThreadMain, NULL) != 0){
+        printf("audio: can't start the audio thread, sounds and music stay off\n");
+        return;
+    }
+    audioRunning = true;
+}
+
+void stopAudioThread(){
+    if (audioRunning){
+        atomic_store(&audioQuit, true);
+        wakeAudioThread();
+        pthread_join(audioThread, NULL);
+        audioRunning = false;
+    }
+    atomic_store(&musicStreaming, false);
+    if (musicDevice){
+        StopAudioStream(musicStream);
+        UnloadAudioStream(musicStream);
+        musicDevice = false;
+    }
+    if (musicWave.frameCount > 0){
+        UnloadWave(musicWave);
+        musicWave = (Wave){ 0 };
+    }
+}
+
+// once per tick, highest priority first so it gets first pick of the voices
+void flushSounds(struct GameWorld* world){
+    if (!world->audible){
+        return;
+    }
+    soundTick++;
+    int started = 0;
+    for (int sound = SOUND_COUNT - 1; sound >= 0; sound--){
+        if (world->soundRequests[sound] > 0 && audioRunning && !headless){
+            if (started == qualityLevels[qualityLevel].soundsPerTick){
+                soundsShed++;
+            }else if (queueSound(sound, qualityLevels[qualityLevel].maxVoices)){
+                started++;
+            }else {
+                audioOverruns++;
+            }
+        }
+        world->soundRequests[sound] = 0;
+    }
+    if (started > 0){
+        wakeAudioThread();
+    }
+}
+
+// drawn on the screen with the other stats (F2)
+void drawAudioStats(){
+    long pulls = atomic_load(&musicPulls);
+    DrawText(TextFormat("AUDIO QUEUE %i/%i PEAK %i, %ld OVERRUNS, MUSIC RING %i/%i LOW %i AVG %i, %ld UNDERRUNS",
+        audioQueueDepth(), AUDIO_QUEUE_SIZE, audioDepthMax, audioOverruns, musicFill(), musicRingFrames,
+        pulls > 0 ? atomic_load(&musicFillLow) : 0, pulls > 0 ? (int)(atomic_load(&musicFillSum) / pulls) : 0, atomic_load(&musicUnderruns)),
+        10, GetScreenHeight() - 95, 10, audioOverruns > 0 || atomic_load(&musicUnderruns) > 0 ? ORANGE : WHITE);
+}
+
+// after stopAudioThread
+void printAudioStats(){
+    struct Percentiles latency = percentiles(audioLatencies, audioLatencyCount < AUDIO_LATENCY_SAMPLES ? audioLatencyCount : AUDIO_LATENCY_SAMPLES);
+    printf("audio: %ld started, %ld overruns, queue peak %i of %i, queued to started %.3f ms p50 %.3f ms p99\n",
+        atomic_load(&audioStarted), audioOverruns, audioDepthMax, AUDIO_QUEUE_SIZE, latency.p50, latency.p99);
+    long pulls = atomic_load(&musicPulls);
+    if (pulls > 0){
+        printf("music: %i frame ring, %ld refills, %ld pulls, fill low %i avg %.0f frames, %ld underruns, %ld frames of silence\n",
+            musicRingFrames, musicRefills, pulls, atomic_load(&musicFillLow), atomic_load(&musicFillSum) / (double)pulls,
+            atomic_load(&musicUnderruns), atomic_load(&musicMissingFrames));
+    }
+}
+
+void clearAudioStats(){
+    audioSequence = 0;
+    audioOverruns = 0;
+    audioDepthMax = 0;
+    audioLatencyCount = 0;
+    atomic_store(&audioStarted, 0);
+    atomic_store(&audioOutOfOrder, 0);
+    musicCursor = 0;
+    musicRefills = 0;
+    atomic_store(&musicHead, 0);
+    atomic_store(&musicTail, 0);
+    atomic_store(&musicPulls, 0);
+    atomic_store(&musicUnderruns, 0);
+    atomic_store(&musicMissingFrames, 0);
+    atomic_store(&musicFillSum, 0);
+    atomic_store(&musicFillLow, MUSIC_RING_MAX_FRAMES);
+}
+
+#define MUSIC_BENCH_TRACK 30000         // frames, every left sample is its frame number + 1
+#define MUSIC_BENCH_PULL 512            // frames, about what a device asks for at a time
+#define MUSIC_BENCH_SECONDS 1.5
+#define MUSIC_BENCH_STALL_MS 60         // the audio thread gets held up this long every third of the run
+
+atomic_bool musicBenchDone = false;
+long musicBenchBroken = 0;              // frames that weren't the one after the last
+
+// stands in for raylib's device thread, pulling on its schedule whatever the audio thread is doing
+void* musicBenchDevice(void* argument){
+    short buffer[MUSIC_BENCH_PULL * MUSIC_CHANNELS];
+    int last = 0;
+    double next = getTimeSeconds();
+    while (!atomic_load(&musicBenchDone)){
+        pullMusic(buffer, MUSIC_BENCH_PULL);
+        for (int n = 0; n < MUSIC_BENCH_PULL; n++){
+            int sample = buffer[n * MUSIC_CHANNELS];
+            if (sample == 0){
+                continue;       // silence
+            }
+            if (last != 0 && sample != last % MUSIC_BENCH_TRACK + 1){
+                musicBenchBroken++;
+            }
+            last = sample;
+        }
+        next += MUSIC_BENCH_PULL / (double)MUSIC_SAMPLE_RATE;
+        waitUntil(next);
+    }
+    return NULL;
+}
+
+// pushes far more sound commands through the queue than a game ever would, with no voices
+// loaded, and checks every one comes out once and in order. then streams a made up track
+// through the music ring at a few sizes against a stand in for the device, holding the
+// audio thread up now and then, and checks it arrives frame for frame. the default ring
+// may not underrun
+bool benchAudio(){
+    const int COMMANDS = 100000;
+    const int RING_SIZES[] = { 1024, 4096, 8192, 32768 };
+    bool passed = true;
+    
+    clearAudioStats();
+    startAudioThread();
+    if (!audioRunning){
+        return false;
+    }
+    long fullWaits = 0;
+    double start = getTimeSeconds();
+    for (int i = 0; i < COMMANDS; i++){
+        while (!queueSound(i % SOUND_COUNT, 8)){
+            fullWaits++;
+            wakeAudioThread();
+            usleep(10);
+        }
+        // a tick starts at most SOUND_COUNT sounds and wakes the thread once
+        if (i % SOUND_COUNT == SOUND_COUNT - 1){
+            wakeAudioThread();
+        }
+    }
+    stopAudioThread();
+    double elapsed = getTimeSeconds() - start;
+    passed = atomic_load(&audioStarted) == COMMANDS && atomic_load(&audioOutOfOrder) == 0;
+    printf("audio queue: %i commands in %.3f s (%.0f/s), %ld waits on a full queue, %ld out of order, %s\n",
+        COMMANDS, elapsed, COMMANDS / elapsed, fullWaits, atomic_load(&audioOutOfOrder),
+        passed ? "every command came out once and in order" : "commands went missing");
+    printAudioStats();
+    
+    int defaultRing = musicRingFrames;
+    printf("music ring against a %i frame pull every %.1f ms, the audio thread stalled %i ms three times\n",
+        MUSIC_BENCH_PULL, MUSIC_BENCH_PULL * 1000.0 / MUSIC_SAMPLE_RATE, MUSIC_BENCH_STALL_MS);
+    printf("%-10s %8s %8s %8s %10s %10s %10s\n", "ring", "ms", "pulls", "refills", "fill low", "underruns", "broken");
+    for (int r = 0; r < (int)(sizeof(RING_SIZES) / sizeof(RING_SIZES[0])); r++){
+        clearAudioStats();
+        musicRingFrames = RING_SIZES[r];
+        musicBenchBroken = 0;
+        short* track = malloc(sizeof(short) * MUSIC_CHANNELS * MUSIC_BENCH_TRACK);
+        for (int n = 0; n < MUSIC_BENCH_TRACK; n++){
+            track[n * MUSIC_CHANNELS] = n + 1;
+            track[n * MUSIC_CHANNELS + 1] = -(n + 1);
+        }
+        musicWave = (Wave){ MUSIC_BENCH_TRACK, MUSIC_SAMPLE_RATE, 16, MUSIC_CHANNELS, track };
+        
+        startAudioThread();
+        pthread_t device;
+        atomic_store(&musicBenchDone, false);
+        if (!audioRunning || pthread_create(&device, NULL, musicBenchDevice, NULL) != 0){
+            stopAudioThread();
+            return false;
+        }
+        for (int third = 0; third < 3; third++){
+            usleep((useconds_t)(MUSIC_BENCH_SECONDS / 3 * 1000000 - MUSIC_BENCH_STALL_MS * 1000));
+            // the thread can't get back to sleep, or out of it, while this is held
+            pthread_mutex_lock(&audioLock);
+            usleep(MUSIC_BENCH_STALL_MS * 1000);
+            pthread_mutex_unlock(&audioLock);
+        }
+        atomic_store(&musicBenchDone, true);
+        pthread_join(device, NULL);
+        stopAudioThread();
+        
+        long underruns = atomic_load(&musicUnderruns);
+        printf("%-10i %8.1f %8ld %8ld %10i %10ld %10ld\n", musicRingFrames, musicRingFrames * 1000.0 / MUSIC_SAMPLE_RATE,
+            atomic_load(&musicPulls), musicRefills, atomic_load(&musicFillLow), underruns, musicBenchBroken);
+        passed = passed && musicBenchBroken == 0 && (musicRingFrames != defaultRing || underruns == 0);
+    }
+    musicRingFrames = defaultRing;
+    printf("audio: %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Particles *
+//------------------------------------------------------------------------------------
+// pows and explosions live in a ring of their own, apart from every gameplay bucket and
+// the collision pass. particles are born oldest first and all live about as long, so
+// the dead pile up at the head and retiring them is just moving it forward. a full ring
+// overwrites its oldest particle. the update is the same arithmetic for every kind, the
+// kind only picks the starting values, so the loops over the ring have no branches
+#define PARTICLE_POW 0
+#define PARTICLE_EXPLOSION 1
+#define PARTICLE_KIND_COUNT 2
+
+struct ParticleKind{
+    int firstSprite;
+    int frameStep;      // animation frames per tick of age in 1/256ths, 0 for a still sprite
+    int lifetime;
+    float scale;
+};
+
+// 86/256 is 1/3 rounded up, exact for any age under 128
+const struct ParticleKind particleKinds[PARTICLE_KIND_COUNT] = {
+    [PARTICLE_POW] = { SPRITE_POW, 0, 20, 1.0f },
+    [PARTICLE_EXPLOSION] = { SPRITE_EXPLOSION, 86, 21, 0.2f },
+};
+
+
+int particleCount(struct GameWorld* world){
+    return world->particles.tail - world->particles.head;
+}
+
+void clearParticles(struct GameWorld* world){
+    world->particles.head = 0;
+    world->particles.tail = 0;
+}
+
+int spawnParticle(struct GameWorld* world, int kind, int x, int y){
+    if (particleCount(world) == MAX_PARTICLES){
+        world->particles.head++;
+        world->particlesOverwritten++;
+    }
+    
+    const struct ParticleKind* k = &particleKinds[kind];
+    int i = world->particles.tail++ & (MAX_PARTICLES - 1);
+    world->particles.x[i] = x;
+    world->particles.y[i] = y;
+    world->particles.previousY[i] = y;
+    world->particles.age[i] = 0;
+    world->particles.lifetime[i] = k->lifetime;
+    world->particles.sprite[i] = k->firstSprite;
+    world->particles.firstSprite[i] = k->firstSprite;
+    world->particles.frameStep[i] = k->frameStep;
+    world->particles.kind[i] = kind;
+    return i;
+}
+
+int spawnPow(struct GameWorld* world, int x, int y){
+    return spawnParticle(world, PARTICLE_POW, x, y);
+}
+
+int spawnExplosion(struct GameWorld* world, int x, int y){
+    playSound(world, SOUND_EXPLOSION);
+    return spawnParticle(world, PARTICLE_EXPLOSION, x, y);
+}
+
+// the live particles as at most two contiguous slot ranges, the second one empty unless the ring wraps
+int particleSpans(struct GameWorld* world, int* firsts, int* lasts){
+    int first = world->particles.head & (MAX_PARTICLES - 1);
+    int count = particleCount(world);
+    if (first + count <= MAX_PARTICLES){
+        firsts[0] = first;
+        lasts[0] = first + count;
+        return 1;
+    }
+    firsts[0] = first;
+    lasts[0] = MAX_PARTICLES;
+    firsts[1] = 0;
+    lasts[1] = first + count - MAX_PARTICLES;
+    return 2;
+}
+
+#if defined(__SSE2__)
+// 32 bit multiply keeping the low halves, sse2 only multiplies two lanes at a time
+__m128i multiplyLow32(__m128i a, __m128i b){
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+// drift with the background, age and pick the animation frame. the same straight
+// line arithmetic for every particle, 4 at a time with sse2 and the rest one by one
+void advanceParticleSpan(struct GameWorld* world, int first, int last, float drift){
+    int* y = world->particles.y;
+    int* age = world->particles.age;
+    int* sprite = world->particles.sprite;
+    const int* firstSprite = world->particles.firstSprite;
+    const int* frameStep = world->particles.frameStep;
+    
+    int i = first;
+#if defined(__SSE2__)
+    __m128 drift4 = _mm_set1_ps(drift);
+    __m128i one4 = _mm_set1_epi32(1);
+    for (; i + 4 <= last; i += 4){
+        __m128i y4 = _mm_loadu_si128((const __m128i*)(y + i));
+        __m128i age4 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(age + i)), one4);
+        __m128i frame4 = _mm_srai_epi32(multiplyLow32(age4, _mm_loadu_si128((const __m128i*)(frameStep + i))), 8);
+        _mm_storeu_si128((__m128i*)(y + i), _mm_cvttps_epi32(_mm_add_ps(_mm_cvtepi32_ps(y4), drift4)));
+        _mm_storeu_si128((__m128i*)(age + i), age4);
+        _mm_storeu_si128((__m128i*)(sprite + i), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(firstSprite + i)), frame4));
+    }
+#endif
+    for (; i < last; i++){
+        y[i] += drift;
+        age[i]++;
+        sprite[i] = firstSprite[i] + ((age[i] * frameStep[i]) >> 8);
+    }
+}
+
+void advanceParticles(struct GameWorld* world){
+    int firsts[2];
+    int lasts[2];
+    int spans = particleSpans(world, firsts, lasts);
+    float drift = world->backgroundSpeed / 4;
+    for (int s = 0; s < spans; s++){
+        advanceParticleSpan(world, firsts[s], lasts[s], drift);
+    }
+    
+    // a pow born after an explosion dies a tick before it, it waits for the head to reach it
+    while (world->particles.head != world->particles.tail){
+        int i = world->particles.head & (MAX_PARTICLES - 1);
+        if (world->particles.age[i] < world->particles.lifetime[i]){
+            break;
+        }
+        world->particles.head++;
+    }
+}
+
+void rememberParticlePositions(struct GameWorld* world){
+    int firsts[2];
+    int lasts[2];
+    int spans = particleSpans(world, firsts, lasts);
+    for (int s = 0; s < spans; s++){
+        memcpy(world->particles.previousY + firsts[s], world->particles.y + firsts[s], sizeof(int) * (lasts[s] - firsts[s]));
+    }
+}
+
+// which particle each slot last counted as shed, one past its number so 0 is none.
+// a particle is numbered by its place in the ring, a rewind or rollback that draws it
+// again doesn't count it twice
+unsigned int shedParticles[MAX_PARTICLES];
+
+bool firstTimeShed(int slot, unsigned int particle){
+    if (shedParticles[slot] == particle + 1){
+        return false;
+    }
+    shedParticles[slot] = particle + 1;
+    return true;
+}
+
+void drawParticles(struct GameWorld* world){
+    int firsts[2];
+    int lasts[2];
+    int spans = particleSpans(world, firsts, lasts);
+    const struct QualityLevel* quality = &qualityLevels[qualityLevel];
+    unsigned int particle = world->particles.head;
+    for (int s = 0; s < spans; s++){
+        for (int i = firsts[s]; i < lasts[s]; i++, particle++){
+            if (world->particles.age[i] >= world->particles.lifetime[i]){
+                continue;
+            }
+            // a particle keeps its slot for life, so thinning by slot never flickers
+            if (world->particles.kind[i] == PARTICLE_EXPLOSION && i % quality->explosionStride != 0){
+                explosionsShed += firstTimeShed(i, particle);
+                continue;
+            }
+            if (world->particles.kind[i] == PARTICLE_POW && !quality->pows){
+                powsShed += firstTimeShed(i, particle);
+                continue;
+            }
+            float scale = particleKinds[world->particles.kind[i]].scale;
+            drawSpriteScaled(LAYER_PARTICLES, world->particles.sprite[i], world->particles.x[i], interpolate(world->particles.previousY[i], world->particles.y[i]), scale, WHITE);
+        }
+    }
+}
+
+// a big explosion keeps setting off small ones around where it started. any number
+// can run at once, they sit packed in [0, emitterCount) like the entity buckets
+#define BIG_EXPLOSION_TICKS 45
+
+void initBigExplosion(struct GameWorld* world, int x, int y){
+    if (world->emitterCount == MAX_EMITTERS){
+        // the oldest one has the fewest explosions left to give
+        memmove(world->emitters, world->emitters + 1, sizeof(struct Emitter) * (MAX_EMITTERS - 1));
+        world->emitterCount--;
+    }
+    world->emitters[world->emitterCount++] = (struct Emitter){ x, y, BIG_EXPLOSION_TICKS };
+}
+
+void updateExplosions(struct GameWorld* world){
+    int kept = 0;
+    for (int e = 0; e < world->emitterCount; e++){
+        struct Emitter* emitter = &world->emitters[e];
+        emitter->timer--;
+        if (emitter->timer % 3 == 1){
+            spawnExplosion(world, gameRandom(world, -10, 10) + emitter->x, gameRandom(world, -10, 10) + emitter->y);
+        }
+        if (emitter->timer > 0){
+            world->emitters[kept++] = *emitter;
+        }
+    }
+    world->emitterCount = kept;
+}
+
+//-------------------------------------------------------------------
+// * entities *
+//-------------------------------------------------------------------
+// every kind of entity lives in its own dense bucket stored as separate arrays.
+// live entities are always packed into [0, count), removing one moves the last
+// entity into the hole. buckets double in size up to MAX_ENTITIES, after that
+// new spawns are dropped and counted in droppedSpawns
+#define NO_PREVIOUS_POSITION -1000000
+#define INITIAL_ENTITY_CAPACITY 64
+
+#define TEAM_PLAYER 0
+#define TEAM_ENEMIES 1
+
+#define ENEMY_SAMUEL 1
+#define ENEMY_LAMPIR 4
+#define ENEMY_TYPE_COUNT 5
+
+// size, base health and look of every enemy type
+struct EnemyArchetype{
+    int width;
+    int height;
+    int health;
+    int sprite;
+    bool bigExplosion;      // dies in a chain of explosions instead of a single one
+};
+
+const struct EnemyArchetype enemyArchetypes[ENEMY_TYPE_COUNT] = {
+    [ENEMY_SAMUEL] = { 25, 40, 120, SPRITE_SAMUEL, false },
+    [ENEMY_LAMPIR] = { 30, 49, 300, SPRITE_LAMPIR, true },
+};
+
+bool growColumn(int** column, int capacity){
+    int* grown = realloc(*column, sizeof(int) * capacity);
+    if (grown == NULL){
+        return false;
+    }
+    *column = grown;
+    return true;
+}
+
+bool growEntities(struct Entities* e){
+    if (e->capacity == MAX_ENTITIES){
+        return false;
+    }
+    
+    int capacity = e->capacity == 0 ? INITIAL_ENTITY_CAPACITY : min(e->capacity * 2, MAX_ENTITIES);
+    bool grown = growColumn(&e->x, capacity) &&
+                 growColumn(&e->y, capacity) &&
+                 growColumn(&e->width, capacity) &&
+                 growColumn(&e->height, capacity) &&
+                 growColumn(&e->health, capacity) &&
+                 growColumn(&e->timer, capacity) &&
+                 growColumn(&e->steer, capacity) &&
+                 growColumn(&e->steerDelay, capacity) &&
+                 growColumn(&e->hitFlash, capacity) &&
+                 growColumn(&e->enemyType, capacity) &&
+                 growColumn(&e->ai, capacity) &&
+                 growColumn(&e->seed, capacity) &&
+                 growColumn(&e->previousX, capacity) &&
+                 growColumn(&e->previousY, capacity);
+    if (grown){
+        e->capacity = capacity;
+    }
+    return grown;
+}
+
+void freeEntities(struct Entities* e){
+    free(e->x);
+    free(e->y);
+    free(e->width);
+    free(e->height);
+    free(e->health);
+    free(e->timer);
+    free(e->steer);
+    free(e->steerDelay);
+    free(e->hitFlash);
+    free(e->enemyType);
+    free(e->ai);
+    free(e->seed);
+    free(e->previousX);
+    free(e->previousY);
+    memset(e, 0, sizeof(*e));
+}
+
+// returns the index of a zeroed entity or -1 when the bucket is full
+int addEntity(struct GameWorld* world, struct Entities* e){
+    if (e->count == e->capacity && !growEntities(e)){
+        world->droppedSpawns++;
+        return -1;
+    }
+    
+    int i = e->count++;
+    e->x[i] = 0;
+    e->y[i] = 0;
+    e->width[i] = 0;
+    e->height[i] = 0;
+    e->health[i] = 0;
+    e->timer[i] = 0;
+    e->steer[i] = 0;
+    e->steerDelay[i] = 0;
+    e->hitFlash[i] = 0;
+    e->enemyType[i] = 0;
+    e->ai[i] = 0;
+    e->seed[i] = 1;
+    e->previousX[i] = NO_PREVIOUS_POSITION;
+    e->previousY[i] = NO_PREVIOUS_POSITION;
+    return i;
+}
+
+void removeEntity(struct Entities* e, int i){
+    int last = --e->count;
+    e->x[i] = e->x[last];
+    e->y[i] = e->y[last];
+    e->width[i] = e->width[last];
+    e->height[i] = e->height[last];
+    e->health[i] = e->health[last];
+    e->timer[i] = e->timer[last];
+    e->steer[i] = e->steer[last];
+    e->steerDelay[i] = e->steerDelay[last];
+    e->hitFlash[i] = e->hitFlash[last];
+    e->enemyType[i] = e->enemyType[last];
+    e->ai[i] = e->ai[last];
+    e->seed[i] = e->seed[last];
+    e->previousX[i] = e->previousX[last];
+    e->previousY[i] = e->previousY[last];
+}
+
+// called before every rendered tick so frames can be drawn between the two
+void rememberPositions(struct Entities* e){
+    memcpy(e->previousX, e->x, sizeof(int) * e->count);
+    memcpy(e->previousY, e->y, sizeof(int) * e->count);
+}
+
+// entities spawned during the last tick have no previous position yet
+float entityDrawX(struct Entities* e, int i){
+    return e->previousX[i] == NO_PREVIOUS_POSITION ? e->x[i] : interpolate(e->previousX[i], e->x[i]);
+}
+
+float entityDrawY(struct Entities* e, int i){
+    return e->previousY[i] == NO_PREVIOUS_POSITION ? e->y[i] : interpolate(e->previousY[i], e->y[i]);
+}
+
+void clearObjects(struct GameWorld* world){
+    world->playerBullets.count = 0;
+    world->enemyBullets.count = 0;
+    world->enemies.count = 0;
+    clearParticles(world);
+    world->emitterCount = 0;
+}
+
+int countObjects(struct GameWorld* world){
+    return world->playerBullets.count + world->enemyBullets.count + world->enemies.count + particleCount(world);
+}
+
+// enemies spawn above the screen, so only entities past this margin count as gone
+#define PLAYFIELD_MARGIN 100
+
+bool isOutsidePlayfield(int x, int y, int w, int h){
+    return x + w < -PLAYFIELD_MARGIN ||
+           x > inGameWidth + PLAYFIELD_MARGIN ||
+           y + h < -PLAYFIELD_MARGIN ||
+           y > inGameHeight + PLAYFIELD_MARGIN;
+}
+
+//-------------------------------------------------------------------
+// * collision kernel *
+//-------------------------------------------------------------------
+// tests one target box against a packed array of boxes and sets bit i of mask
+// for every box i that overlaps it. answers are exactly what checkBoxCollisions
+// gives, the vector paths just do 8 (avx2) or 4 (sse2) boxes per step
+const char* collisionKernelName(){
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void collideBoxBatch(int tx, int ty, int tw, int th, const int* xs, const int* ys, const int* ws, const int* hs, int count, unsigned int* mask){
+    for (int w = 0; w < MASK_WORDS(count); w++){
+        mask[w] = 0;
+    }
+    
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i right8 = _mm256_set1_epi32(tx + tw);
+    __m256i left8 = _mm256_set1_epi32(tx);
+    __m256i bottom8 = _mm256_set1_epi32(ty + th);
+    __m256i top8 = _mm256_set1_epi32(ty);
+    for (; i + 8 <= count; i += 8){
+        __m256i x = _mm256_loadu_si256((const __m256i*)(xs + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(ys + i));
+        __m256i w = _mm256_loadu_si256((const __m256i*)(ws + i));
+        __m256i h = _mm256_loadu_si256((const __m256i*)(hs + i));
+        __m256i hit = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(right8, x), _mm256_cmpgt_epi32(_mm256_add_epi32(x, w), left8)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(bottom8, y), _mm256_cmpgt_epi32(_mm256_add_epi32(y, h), top8)));
+        mask[i / 32] |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(hit)) << (i % 32);
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i right4 = _mm_set1_epi32(tx + tw);
+    __m128i left4 = _mm_set1_epi32(tx);
+    __m128i bottom4 = _mm_set1_epi32(ty + th);
+    __m128i top4 = _mm_set1_epi32(ty);
+    for (; i + 4 <= count; i += 4){
+        __m128i x = _mm_loadu_si128((const __m128i*)(xs + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(ys + i));
+        __m128i w = _mm_loadu_si128((const __m128i*)(ws + i));
+        __m128i h = _mm_loadu_si128((const __m128i*)(hs + i));
+        __m128i hit = _mm_and_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(right4, x), _mm_cmpgt_epi32(_mm_add_epi32(x, w), left4)),
+            _mm_and_si128(_mm_cmpgt_epi32(bottom4, y), _mm_cmpgt_epi32(_mm_add_epi32(y, h), top4)));
+        mask[i / 32] |= (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(hit)) << (i % 32);
+    }
+#endif
+    for (; i < count; i++){
+        if (checkBoxCollisions(tx, ty, tw, th, xs[i], ys[i], ws[i], hs[i])){
+            mask[i / 32] |= 1u << (i % 32);
+        }
+    }
+}
+
+bool anyBitSet(unsigned int* mask, int count){
+    for (int w = 0; w < MASK_WORDS(count); w++){
+        if (mask[w] != 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------
+// * collision grid *
+//-------------------------------------------------------------------
+// player bullets are sorted by the grid cell their top left corner is in, so the
+// bullets of one row of cells sit next to each other in the binned arrays and an
+// enemy can hand each row to the collision kernel as a single packed range.
+// bullets are never bigger than a cell, so looking one cell up and to the left of
+// an enemy catches every bullet reaching into it.
+// bullets outside the playfield are clamped into the border cells
+
+// switches the broad phase off and tests every bullet against every enemy, kept around for comparisons
+bool bruteForceCollisions = false;
+
+int gridColumn(int x){
+    int column = x / GRID_CELL_SIZE;
+    if (x < 0 || column < 0){
+        return 0;
+    }
+    return min(column, GRID_COLUMNS - 1);
+}
+
+int gridRow(int y){
+    int row = y / GRID_CELL_SIZE;
+    if (y < 0 || row < 0){
+        return 0;
+    }
+    return min(row, GRID_ROWS - 1);
+}
+
+// counting sort of the player bullets by cell
+void rebuildCollisionGrid(struct GameWorld* world){
+    for (int cell = 0; cell <= GRID_CELLS; cell++){
+        world->gridCellStart[cell] = 0;
+    }
+    
+    for (int i = 0; i < world->playerBullets.count; i++){
+        int cell = gridRow(world->playerBullets.y[i]) * GRID_COLUMNS + gridColumn(world->playerBullets.x[i]);
+        world->gridCellOf[i] = cell;
+        world->gridCellStart[cell + 1]++;
+    }
+    for (int cell = 0; cell < GRID_CELLS; cell++){
+        world->gridCellStart[cell + 1] += world->gridCellStart[cell];
+    }
+    
+    int cursor[GRID_CELLS];
+    memcpy(cursor, world->gridCellStart, sizeof(cursor));
+    for (int i = 0; i < world->playerBullets.count; i++){
+        int slot = cursor[world->gridCellOf[i]]++;
+        world->binnedX[slot] = world->playerBullets.x[i];
+        world->binnedY[slot] = world->playerBullets.y[i];
+        world->binnedWidth[slot] = world->playerBullets.width[i];
+        world->binnedHeight[slot] = world->playerBullets.height[i];
+        world->binnedIndex[slot] = i;
+    }
+}
+
+// queues a hit for every set bit of the mask, applyCommands lets the first enemy that hit a bullet use it up
+void hitEnemyWithBullets(struct GameWorld* world, int worker, int enemyIndex, const int* bulletIndices, int count){
+    unsigned int* mask = world->collisionMask[worker];
+    for (int w = 0; w < MASK_WORDS(count); w++){
+        for (unsigned int bits = mask[w]; bits != 0; bits &= bits - 1){
+            int bit = 0;
+            while (!(bits & (1u << bit))){
+                bit++;
+            }
+            int bulletIndex = bulletIndices == NULL ? w * 32 + bit : bulletIndices[w * 32 + bit];
+            pushCommand(world, worker, COMMAND_HIT_ENEMY, bulletIndex, enemyIndex, 0);
+        }
+    }
+}
+
+void collideEnemyRange(struct GameWorld* world, int worker, int first, int last){
+    unsigned int* mask = world->collisionMask[worker];
+    for (int e = first; e < last; e++){
+        int x = world->enemies.x[e];
+        int y = world->enemies.y[e];
+        int w = world->enemies.width[e];
+        int h = world->enemies.height[e];
+        
+        if (bruteForceCollisions){
+            collideBoxBatch(x, y, w, h, world->playerBullets.x, world->playerBullets.y, world->playerBullets.width, world->playerBullets.height, world->playerBullets.count, mask);
+            world->commandBuffers[worker].pairTests += world->playerBullets.count;
+            hitEnemyWithBullets(world, worker, e, NULL, world->playerBullets.count);
+            continue;
+        }
+        
+        int firstColumn = gridColumn(x) - (gridColumn(x) > 0);
+        int lastColumn = gridColumn(x + w - 1);
+        int lastRow = gridRow(y + h - 1);
+        for (int row = gridRow(y) - (gridRow(y) > 0); row <= lastRow; row++){
+            int start = world->gridCellStart[row * GRID_COLUMNS + firstColumn];
+            int count = world->gridCellStart[row * GRID_COLUMNS + lastColumn + 1] - start;
+            if (count == 0){
+                continue;
+            }
+            collideBoxBatch(x, y, w, h, world->binnedX + start, world->binnedY + start, world->binnedWidth + start, world->binnedHeight + start, count, mask);
+            world->commandBuffers[worker].pairTests += count;
+            hitEnemyWithBullets(world, worker, e, world->binnedIndex + start, count);
+        }
+    }
+}
+
+void collideObjects(struct GameWorld* world){
+    rebuildCollisionGrid(world);
+    for (int i = 0; i < world->playerBullets.count; i++){
+        world->bulletUsed[i] = false;
+    }
+    
+    runParallel(world, "enemy collisions", collideEnemyRange, world->enemies.count);
+    applyCommands(world);
+    
+    // backwards so removing a bullet never moves an unchecked one
+    for (int i = world->playerBullets.count - 1; i >= 0; i--){
+        if (world->bulletUsed[i]){
+            removeEntity(&world->playerBullets, i);
+        }
+    }
+}
+
+// the player's 16x16 box against enemy bullets and enemy bodies
+bool playerIsHit(struct GameWorld* world, int x, int y){
+    collideBoxBatch(x, y, 16, 16, world->enemyBullets.x, world->enemyBullets.y, world->enemyBullets.width, world->enemyBullets.height, world->enemyBullets.count, world->collisionMask[0]);
+    world->collisionPairTests += world->enemyBullets.count;
+    if (anyBitSet(world->collisionMask[0], world->enemyBullets.count)){
+        return true;
+    }
+    
+    collideBoxBatch(x, y, 16, 16, world->enemies.x, world->enemies.y, world->enemies.width, world->enemies.height, world->enemies.count, world->collisionMask[0]);
+    world->collisionPairTests += world->enemies.count;
+    return anyBitSet(world->collisionMask[0], world->enemies.count);
+}
+
+void updateObjects(struct GameWorld* world){
+    updateEnemies(world);
+    advanceBullets(&world->enemyBullets, 3);
+    advanceBullets(&world->playerBullets, -5);
+    advanceParticles(world);
+    
+    // collision
+    profileBegin(PROFILE_COLLISIONS);
+    collideObjects(world);
+    profileEnd(PROFILE_COLLISIONS);
+}
+
+void drawObjects(struct GameWorld* world){
+    drawEnemies(world);
+    drawBullets(&world->enemyBullets, SPRITE_ENEMY_BULLET);
+    drawBullets(&world->playerBullets, SPRITE_BULLET);
+    drawParticles(world);
+}
+
+//-------------------------------------------------------------------
+// * bullets *
+//-------------------------------------------------------------------
+void advanceBullets(struct Entities* bullets, int speed){
+    int* y = bullets->y;
+    int count = bullets->count;
+    
+    for (int i = 0; i < count; i++){
+        y[i] += speed;
+    }
+    
+    for (int i = count - 1; i >= 0; i--){
+        if (y[i] <= 0 || y[i] > inGameHeight){
+            removeEntity(bullets, i);
+        }
+    }
+}
+
+void drawBullets(struct Entities* bullets, int sprite){
+    for (int i = 0; i < bullets->count; i++){
+        drawSprite(LAYER_BULLETS, sprite, entityDrawX(bullets, i), entityDrawY(bullets, i), WHITE);
+    }
+}
+
+int spawnBullet(struct GameWorld* world, int x, int y, int team){
+    struct Entities* bullets = team == TEAM_PLAYER ? &world->playerBullets : &world->enemyBullets;
+    int i = addEntity(world, bullets);
+    if (i < 0){
+        return i;
+    }
+    
+    bullets->x[i] = x;
+    bullets->y[i] = y;
+    bullets->width[i] = 16;
+    bullets->height[i] = 16;
+    
+    return i;
+}
+
+void bulletCollide(struct GameWorld* world, int bulletIndex, int enemyIndex){
+    world->enemies.health[enemyIndex] -= 10;
+    world->enemies.hitFlash[enemyIndex] = 5;
+    spawnPow(world, world->playerBullets.x[bulletIndex], world->playerBullets.y[bulletIndex] - 10);
+}
+
+//-------------------------------------------------------------------
+// * enemies *
+//-------------------------------------------------------------------
+
+
+int spawnEnemy(struct GameWorld* world, int x , int enemyType, int aiType, float healthMultiplier){
+    int i = addEntity(world, &world->enemies);
+    if (i < 0){
+        return i;
+    }
+    
+    world->enemies.x[i] = x;
+    world->enemies.y[i] = -64;
+    world->enemies.enemyType[i] = enemyType;
+    world->enemies.ai[i] = aiType;
+    world->enemies.seed[i] = gameRandom(world, 1, 0x7ffffffe);
+    
+    const struct EnemyArchetype* archetype = &enemyArchetypes[enemyType];
+    world->enemies.width[i] = archetype->width;
+    world->enemies.height[i] = archetype->height;
+    world->enemies.health[i] = (int)(archetype->health * healthMultiplier);
+    
+    return i;
+}
+
+//-------------------------------------------------------------------
+// * samuel *
+//-------------------------------------------------------------------
+// steering goes for whichever player is closest across, a dead one keeps its last spot
+static inline int targetPlayerX(struct GameWorld* world, int x){
+    int target = world->playerX[0];
+    for (int p = 1; p < world->playerCount; p++){
+        target = abs(world->playerX[p] - x) < abs(target - x) ? world->playerX[p] : target;
+    }
+    return target;
+}
+
+const int AI_DEFAULT = 0;
+const int AI_DIVE = 1;
+const int AI_SHOOT = 2;
+const int AI_SHOOT_DIVE = 3;
+const int AI_SNIPER = 4;
+#define ENEMY_HOLD_LINE 100     // snipers stop here, divers stop steering past it
+
+// what each ai does, indexed by the AI_ constants
+struct AiBehaviour{
+    int holdsLine;          // stops descending at ENEMY_HOLD_LINE
+    int diveSpeed;          // extra speed past diveDepth
+    int diveDepth;
+    int steersPastLine;     // keeps steering towards the player below ENEMY_HOLD_LINE
+    int retargetInterval;   // also picks a new steering direction every this many ticks, 0 for never
+    int fireInterval;       // ticks between shots, 0 for never
+};
+
+const struct AiBehaviour aiBehaviours[AI_COUNT] = {
+    { 0, 0, 0,   1, 0,   0 },       // AI_DEFAULT
+    { 0, 2, 120, 0, 0,   0 },       // AI_DIVE
+    { 0, 0, 0,   1, 0,   120 },     // AI_SHOOT
+    { 0, 2, 120, 0, 0,   120 },     // AI_SHOOT_DIVE
+    { 1, 0, 0,   1, 100, 120 },     // AI_SNIPER
+    { 0, 0, 0,   0, 0,   0 },       // 5, steers until ENEMY_HOLD_LINE and then drifts straight down
+};
+
+// one enemy from a group that shares a behaviour. the behaviour's fields are loop
+// invariant, movement is plain arithmetic so only steering and firing still branch
+static inline __attribute__((always_inline)) void updateEnemyWithBehaviour(struct GameWorld* world, int worker, int i, const struct AiBehaviour* behaviour){
+    int x = world->enemies.x[i];
+    int y = world->enemies.y[i];
+    int timer = world->enemies.timer[i];
+    
+    y += !behaviour->holdsLine | (y < ENEMY_HOLD_LINE);
+    y += behaviour->diveSpeed * (y > behaviour->diveDepth);
+    
+    if (behaviour->steersPastLine | (y < ENEMY_HOLD_LINE)){
+        if ((y % 80 == 0 && randomFrom((unsigned int*)&world->enemies.seed[i], 0, 9) <= 7) ||
+            (behaviour->retargetInterval != 0 && timer % behaviour->retargetInterval == 0)){
+            int target = targetPlayerX(world, x);
+            if (x < target - 10 || x > target + 26){
+                world->enemies.steer[i] = (x < target) * 2 - 1;
+            }
+            world->enemies.steerDelay[i] = 10;
+        }
+        
+        int steerDelay = world->enemies.steerDelay[i];
+        if (world->enemies.steer[i] != 0 && y % steerDelay == 0){
+            x += world->enemies.steer[i];
+            world->enemies.steerDelay[i] = steerDelay - (steerDelay > 1);
+        }
+    }
+    
+    timer++;
+    if (behaviour->fireInterval != 0 && timer % behaviour->fireInterval == 0){
+        pushCommand(world, worker, COMMAND_SPAWN_BULLET, x + 6, y + 6, TEAM_ENEMIES);
+    }
+    
+    world->enemies.x[i] = x;
+    world->enemies.y[i] = y;
+    world->enemies.timer[i] = timer;
+    world->enemies.hitFlash[i] -= world->enemies.hitFlash[i] > 0;
+}
+
+// replays every worker's commands on the main thread, removals wait until the
+// end so the indices the commands carry stay valid
+void applyCommands(struct GameWorld* world){
+    int removedCount = 0;
+    for (int worker = 0; worker < workerCount; worker++){
+        struct CommandBuffer* buffer = &world->commandBuffers[worker];
+        for (int c = 0; c < buffer->count; c++){
+            struct Command* command = &buffer->commands[c];
+            switch (command->type){
+                case COMMAND_SPAWN_BULLET:
+                    spawnBullet(world, command->a, command->b, command->c);
+                    break;
+                case COMMAND_KILL_ENEMY:
+                    // smrt
+                    if (!enemyArchetypes[world->enemies.enemyType[command->a]].bigExplosion){
+                        spawnExplosion(world, world->enemies.x[command->a], world->enemies.y[command->a]);
+                    }else {
+                        initBigExplosion(world, world->enemies.x[command->a], world->enemies.y[command->a]);
+                    }
+                    killedEnemy(world);
+                    world->removedEnemies[removedCount++] = command->a;
+                    break;
+                case COMMAND_REMOVE_ENEMY:
+                    world->removedEnemies[removedCount++] = command->a;
+                    break;
+                case COMMAND_HIT_ENEMY:
+                    if (!world->bulletUsed[command->a]){
+                        world->bulletUsed[command->a] = true;
+                        bulletCollide(world, command->a, command->b);
+                    }
+                    break;
+            }
+        }
+        buffer->count = 0;
+        world->collisionPairTests += buffer->pairTests;
+        buffer->pairTests = 0;
+    }
+    
+    // workers cover ascending ranges so the list is sorted, going backwards never moves a removed enemy
+    for (int i = removedCount - 1; i >= 0; i--){
+        removeEntity(&world->enemies, world->removedEnemies[i]);
+    }
+}
+
+// queues the dead and the gone on the main thread's buffer and counting sorts the rest
+// by ai. the buffer is replayed first, so command order stays the same for any thread count
+void groupEnemies(struct GameWorld* world){
+    int counts[AI_COUNT + 1] = { 0 };
+    int* ai = world->enemies.ai;
+    for (int i = 0; i < world->enemies.count; i++){
+        if (world->enemies.health[i] <= 0){
+            pushCommand(world, 0, COMMAND_KILL_ENEMY, i, 0, 0);
+            ai[i] = -1 - ai[i];
+        }else if (isOutsidePlayfield(world->enemies.x[i], world->enemies.y[i], world->enemies.width[i], world->enemies.height[i]) || world->enemies.y[i] > inGameHeight){
+            pushCommand(world, 0, COMMAND_REMOVE_ENEMY, i, 0, 0);
+            ai[i] = -1 - ai[i];
+        }else {
+            counts[ai[i] + 1]++;
+        }
+    }
+    
+    world->aiGroupStart[0] = 0;
+    for (int g = 0; g < AI_COUNT; g++){
+        world->aiGroupStart[g + 1] = world->aiGroupStart[g] + counts[g + 1];
+    }
+    int cursor[AI_COUNT];
+    memcpy(cursor, world->aiGroupStart, sizeof(cursor));
+    for (int i = 0; i < world->enemies.count; i++){
+        if (ai[i] < 0){
+            // the removed ones keep their ai for the kill command
+            ai[i] = -1 - ai[i];
+        }else {
+            world->enemyOrder[cursor[ai[i]]++] = i;
+        }
+    }
+}
+
+// called with a constant ai so every group gets its own copy of the loop with the
+// behaviour folded in, the intervals turn into constants and their divisions into multiplies
+static inline __attribute__((always_inline)) void updateBehaviourGroup(struct GameWorld* world, int worker, int ai, int first, int last){
+    int groupFirst = world->aiGroupStart[ai] > first ? world->aiGroupStart[ai] : first;
+    int groupLast = world->aiGroupStart[ai + 1] < last ? world->aiGroupStart[ai + 1] : last;
+    for (int n = groupFirst; n < groupLast; n++){
+        updateEnemyWithBehaviour(world, worker, world->enemyOrder[n], &aiBehaviours[ai]);
+    }
+}
+
+// a worker's slice of enemyOrder, walked one behaviour group at a time. one line per ai
+_Static_assert(AI_COUNT == 6, "updateEnemyRange needs a line for every ai");
+void updateEnemyRange(struct GameWorld* world, int worker, int first, int last){
+    updateBehaviourGroup(world, worker, 0, first, last);
+    updateBehaviourGroup(world, worker, 1, first, last);
+    updateBehaviourGroup(world, worker, 2, first, last);
+    updateBehaviourGroup(world, worker, 3, first, last);
+    updateBehaviourGroup(world, worker, 4, first, last);
+    updateBehaviourGroup(world, worker, 5, first, last);
+}
+
+void updateEnemies(struct GameWorld* world){
+    groupEnemies(world);
+    runParallel(world, "enemy updates", updateEnemyRange, world->aiGroupStart[AI_COUNT]);
+    applyCommands(world);
+}
+
+void drawEnemies(struct GameWorld* world){
+    for (int i = 0; i < world->enemies.count; i++){
+        Color c = WHITE;
+        // color
+        if (world->enemies.hitFlash[i] > 0){
+            c.r = RED.r;//(unsigned char) lerp((float)c.r, (float)RED.r, this->variable3 / 10);
+            c.g = RED.g;
+            c.b = RED.b;
+        }
+        
+        int spr = enemyArchetypes[world->enemies.enemyType[i]].sprite;
+        drawSprite(LAYER_ENEMIES, spr, entityDrawX(&world->enemies, i), entityDrawY(&world->enemies, i), c);
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+// * player *
+//-------------------------------------------------------------------
+int playerHealth = 3;
+
+const int BOUNDRY_WIDTH = 10;
+const int BOUNDRY_HEIGHT = 100;
+
+void updatePlayer(struct GameWorld* world, struct Player* data, int slot, int input){
+    // setup vals
+    data->direction = 0;
+    
+    
+    // movement
+    if (data->deadTimer == 0){    
+        if (data->x > BOUNDRY_WIDTH && (input & INPUT_LEFT)){
+            data->x -= 2;
+            data->direction = -1;
+        }
+        else if (data->x < inGameWidth - BOUNDRY_WIDTH - 16 && (input & INPUT_RIGHT)){
+            data->x += 2;
+            data->direction = 1;
+        }
+        
+        if (data->y < inGameHeight - BOUNDRY_WIDTH - 16 && (input & INPUT_DOWN)){
+            data->y += 1;
+        }else if (data->y > inGameHeight - BOUNDRY_HEIGHT && (input & INPUT_UP)){
+            data->y -= 1;
+        }
+    
+        
+        world->playerX[slot] = data->x;
+        world->playerY[slot] = data->y;
+        data->projectileCount = world->playerLevel;
+        // shooting
+        if ((input & INPUT_FIRE) && data->fireCooldown == 0){
+            if (data->projectileCount == 1 || data->projectileCount == 3){
+                spawnBullet(world, data->x, data->y, TEAM_PLAYER);
+            }
+            if (data->projectileCount == 2 || data->projectileCount == 3){
+                spawnBullet(world, data->x - 3, data->y + 2, TEAM_PLAYER);
+                spawnBullet(world, data->x + 3, data->y + 2, TEAM_PLAYER);
+                            
+            }
+            
+            data->fireCooldown = data->fireRate;
+            playSound(world, SOUND_SHOOT_PLAYER);
+        }
+        data->fireCooldown -= data->fireCooldown > 0;
+    }
+    
+    
+    // collisions
+    if (data->deadTimer == 0 && data->invinciblity == 0 && playerIsHit(world, data->x, data->y)){
+        data->deadTimer++;
+        spawnExplosion(world, data->x - 10, data->y - 10);
+    }
+    
+    
+    
+    data->deadTimer += data->deadTimer != 0;
+    data->invinciblity -= data->invinciblity > 0;
+}
+
+void drawPlayer(struct Player* data, Color tint){
+    int sprite = SPRITE_PLAYER;
+    if (data->direction < 0){
+        sprite = SPRITE_PLAYER_LEFT;
+    }else if (data->direction > 0){
+        sprite = SPRITE_PLAYER_RIGHT;
+    }
+    if (data->invinciblity % 4 < 2 && data->deadTimer == 0){
+        drawSprite(LAYER_PLAYER, sprite, interpolate(data->previousX, data->x), interpolate(data->previousY, data->y), tint);
+    }
+}
+
+struct Player initPlayer(struct GameWorld* world){
+    struct Player output;
+    
+    output.y = inGameHeight - 40;
+    output.x = inGameWidth / 2 - 8;
+    output.fireRate = 10;
+    output.fireCooldown = 0;
+    output.projectileCount = 1;
+    output.invinciblity = 180;
+    output.deadTimer = 0;
+    output.direction = 0;
+    output.previousX = output.x;
+    output.previousY = output.y;
+    world->playerLevel = 1;
+    world->killedThisLife = 0;
+    return output;
+}
+
+// players stand spread evenly across the bottom, one player stands in the middle
+struct Player initPlayerSlot(struct GameWorld* world, int slot){
+    struct Player output = initPlayer(world);
+    output.x = inGameWidth * (slot + 1) / (world->playerCount + 1) - 8;
+    output.previousX = output.x;
+    return output;
+}
+
+//-------------------------------------------------------------------
+// * enemy management *
+//-------------------------------------------------------------------
+void upgrade(struct GameWorld* world){
+    world->upgradeTimer = 60;
+    playSound(world, SOUND_BONUS);
+    if (world->playerLevel < 3){
+        world->playerLevel++;
+    }else{
+        world->playerLives++;
+    }
+}
+
+void updateEnemyManagement(struct GameWorld* world){
+    world->enemySpawnTimer--;
+    if (world->enemySpawnTimer <= 0){
+        
+        int enemyType = ENEMY_SAMUEL;
+        if (gameRandom(world, 0, 100) < min(world->enemiesKilled, 90)){
+            enemyType = ENEMY_LAMPIR;
+        }
+        
+        int aiType = gameRandom(world, 0, (world->enemiesKilled > 10) + (world->enemiesKilled > 30) + (world->enemiesKilled > 40) + (world->enemiesKilled > 50) + (world->enemiesKilled > 60));
+        
+        
+        float healthMultiplier = 1.0f;
+        //healthMultiplier += (sin(enemiesKilled) + 1) * 0.2f;
+        
+        spawnEnemy(world, gameRandom(world, 0, inGameWidth - 32), enemyType, aiType, healthMultiplier);
+        world->enemySpawnTimer = 40 + (sin(world->enemiesKilled) * 10) + (80 * (world->enemiesKilled < 20)) + (40 * (world->enemiesKilled < 60)) + (40 * (world->enemiesKilled < 120));
+    }
+}   
+
+void killedEnemy(struct GameWorld* world){
+    world->enemiesKilled++;
+    world->killedThisLife++;
+    
+    if ((world->playerLevel == 1 && world->killedThisLife % 10 == 0) ||
+        (world->playerLevel == 2 && world->killedThisLife % 35 == 0) ||
+        (world->playerLevel >= 3 && world->killedThisLife % 90 == 0)){
+        upgrade(world);
+    }
+    
+    if (world->enemiesKilled % 30 == 0){
+        changeBackground(world);
+    }
+}
+
+//-------------------------------------------------------------------
+// * reset *
+//-------------------------------------------------------------------
+
+void reset(struct GameWorld* world){
+    world->enemySpawnTimer = 0;
+    world->enemiesKilled = 0;
+    world->playerLives = 3;
+    world->playerLevel = 1;
+    world->killedThisLife = 0;
+    world->currentBackground = 0;
+    world->movedBackgrounds = 0;
+    world->backgroundSpeed = 0;
+    world->backgroundOffset = 0;
+    world->fadeTimer = 0;
+    world->upgradeTimer = 0;
+    for (int p = 0; p < MAX_PLAYERS; p++){
+        world->players[p] = initPlayerSlot(world, p);
+        world->playerX[p] = 0;
+        world->playerY[p] = 0;
+    }
+    
+    clearObjects(world);
+}
+
+// a fresh game, seeded with 1 until someone seeds it. the world is big, it lives on the heap
+struct GameWorld* createWorld(){
+    struct GameWorld* world = aligned_alloc(_Alignof(struct GameWorld), sizeof(struct GameWorld));
+    if (world == NULL){
+        return NULL;
+    }
+    memset(world, 0, sizeof(struct GameWorld));
+    world->randomState = 1;
+    world->playerCount = 1;
+    world->audible = true;
+    reset(world);
+    return world;
+}
+
+void destroyWorld(struct GameWorld* world){
+    if (world == NULL){
+        return;
+    }
+    freeEntities(&world->playerBullets);
+    freeEntities(&world->enemyBullets);
+    freeEntities(&world->enemies);
+    for (int worker = 0; worker < MAX_WORKERS; worker++){
+        free(world->commandBuffers[worker].commands);
+    }
+    free(world);
+}
+
+void gameOver(struct GameWorld* world, int input){
+    if (input & INPUT_RESTART){
+        reset(world);
+    }
+}
+
+void drawGameOver(){
+    drawText(LAYER_HUD, "KONEC HRY", 50, 200, 20, WHITE);
+    drawText(LAYER_HUD, "STISKNI R PRO RESTART", 50, 300, 1, WHITE);
+}
+
+
+//-------------------------------------------------------------------
+// * hud *
+//-------------------------------------------------------------------
+// the hud is drawn into a layer of its own, only again when something on it changed,
+// and goes into the draw queue as a single draw. the gpu keeps the layer in a render
+// texture, the software renderer in pixels laid out like the framebuffer
+#define HUD_HEIGHT 64                           // game pixels from the top, everything the hud writes fits above
+#define HUD_ROWS (int)(HUD_HEIGHT * screenZoom)
+
+// what the hud shows, it gets drawn again whenever this differs from the last time
+struct HudState{
+    int lives;
+    int score;
+    bool bonus;
+};
+
+RenderTexture2D hudTexture;
+bool hudTextureLoaded = false;
+Color* hudPixels = NULL;
+struct HudState hudShown;
+bool hudValid = false;
+long hudRedraws = 0;
+
+void updateHud(struct GameWorld* world){
+    world->upgradeTimer-= world->upgradeTimer > 0;
+}
+
+struct HudState hudStateOf(struct GameWorld* world){
+    struct HudState state = { 0 };
+    state.lives = world->playerLives;
+    state.score = world->enemiesKilled;
+    state.bonus = world->upgradeTimer % 8 > 4;
+    return state;
+}
+
+// field by field, the padding after bonus is never written
+bool sameHudState(const struct HudState* a, const struct HudState* b){
+    return a->lives == b->lives && a->score == b->score && a->bonus == b->bonus;
+}
+
+void drawHudText(const char* text, int x, int y){
+    if (softwareRender){
+        softwareDrawText(text, x, y, 1, WHITE);
+    }else {
+        DrawText(text, x, y, 1, WHITE);
+    }
+}
+
+void rasterizeHud(const struct HudState* hud){
+    char lives[16];
+    char score[16];
+    snprintf(lives, sizeof(lives), "%i", hud->lives);
+    snprintf(score, sizeof(score), "%i00", hud->score);
+    drawHudText("ZIVOTY : ", 5, 30);
+    drawHudText(lives, 60, 30);
+    drawHudText(score, 180, 30);
+    
+    if (hud->bonus){
+        drawHudText("BONUS!", 100, 50);
+    }
+}
+
+// has to run outside of any texture mode, raylib can't nest them
+void refreshHud(struct GameWorld* world){
+    struct HudState state = hudStateOf(world);
+    if (hudValid && sameHudState(&state, &hudShown)){
+        return;
+    }
+    
+    profileBegin(PROFILE_HUD);
+    if (softwareRender){
+        if (hudPixels == NULL){
+            hudPixels = malloc(sizeof(Color) * screenWidth * HUD_ROWS);
+            if (hudPixels == NULL){
+                return;
+            }
+        }
+        // the software text only ever draws into framebuffer, so it gets pointed at the layer for a moment
+        Color* screen = framebuffer;
+        framebuffer = hudPixels;
+        framebufferRows = HUD_ROWS;
+        memset(hudPixels, 0, sizeof(Color) * screenWidth * HUD_ROWS);
+        rasterizeHud(&state);
+        framebuffer = screen;
+        framebufferRows = screenHeight;
+    }else {
+        if (!hudTextureLoaded){
+            hudTexture = LoadRenderTexture(screenWidth, HUD_ROWS);
+            hudTextureLoaded = true;
+        }
+        Camera2D cam = { 0 };
+        cam.zoom = screenZoom;
+        BeginTextureMode(hudTexture);
+            ClearBackground(BLANK);
+            BeginMode2D(cam);
+            rasterizeHud(&state);
+            EndMode2D();
+        EndTextureMode();
+    }
+    profileEnd(PROFILE_HUD);
+    
+    hudShown = state;
+    hudValid = true;
+    hudRedraws++;
+}
+
+// the layer as the draw queue replays it, on top of whatever is in the framebuffer or render texture
+void drawHudLayer(){
+    if (softwareRender){
+        if (hudPixels == NULL){
+            return;
+        }
+        for (int row = 0; row < HUD_ROWS; row++){
+            blendSpan(framebuffer + row * screenWidth, hudPixels + row * screenWidth, screenWidth, WHITE);
+        }
+    }else if (hudTextureLoaded){
+        // render textures come out upside down
+        Rectangle source = { 0, 0, (float)screenWidth, (float)-HUD_ROWS };
+        Rectangle dest = { 0, 0, (float)inGameWidth, (float)HUD_HEIGHT };
+        Vector2 origin = { 0, 0 };
+        DrawTexturePro(hudTexture.texture, source, dest, origin, 0.0f, WHITE);
+    }
+}
+
+void unloadHud(){
+    if (hudTextureLoaded){
+        UnloadRenderTexture(hudTexture);
+        hudTextureLoaded = false;
+    }
+    free(hudPixels);
+    hudPixels = NULL;
+    hudValid = false;
+}
+
+void drawHud(){
+    queueHudLayer();
+}
+
+//------------------------------------------------------------------------------------
+// * Background *
+//------------------------------------------------------------------------------------
+void updateBackground(struct GameWorld* world){
+    world->backgroundSpeed += (world->backgroundSpeed < (MAX_BACKGROUND_SPEED * world->movedBackgrounds) + 3.5f) * 0.005f;
+    world->backgroundOffset += world->backgroundSpeed;
+    if (world->backgroundOffset > 400){
+        world->backgroundOffset -= 400;
+    }
+    
+    // fading
+    world->fadeTimer -= world->fadeTimer > 0;
+    if (world->fadeTimer == 60){
+        world->currentBackground++;
+        world->currentBackground %= 3;
+        world->movedBackgrounds++;
+    }
+}
+
+void drawBackground(struct GameWorld* world){
+    int spr = SPRITE_MUD_BACKGROUND;
+    switch (world->currentBackground){
+        case 0: spr = SPRITE_MUD_BACKGROUND; break;
+        case 1: spr = SPRITE_GRASS_BACKGROUND; break;
+        case 2: spr = SPRITE_SAND_BACKGROUND; break;
+            
+            
+    }
+    
+    Color c = WHITE;
+    unsigned char dist = (abs(world->fadeTimer - 60.0f) / 60.0f) * 255;
+    c.r = dist;
+    c.g = dist;
+    c.b = dist;
+    
+    
+    
+    float offset = interpolate(world->previousBackgroundOffset, world->backgroundOffset);
+    drawSprite(LAYER_BACKGROUND, spr, 0, offset, c);
+    drawSprite(LAYER_BACKGROUND, spr, 0, offset - 400, c);
+    
+    
+}
+
+void changeBackground(struct GameWorld* world){
+    world->fadeTimer = 120;
+}
+
+
+
+
+//------------------------------------------------------------------------------------
+// * Game loop *
+//------------------------------------------------------------------------------------
+
+// the simulation always advances in steps of TICK_TIME, rendering runs at whatever rate the display allows
+#define TICK_RATE 60
+#define TICK_TIME (1.0 / TICK_RATE)
+#define MAX_TICKS_PER_FRAME 15      // after a stall longer than this the game skips ahead instead of spiralling
+
+// advances the whole simulation by one tick, never touches the renderer.
+// input holds one byte for each of the world's players (see INPUT_BITS).
+// lives, level and score are shared, so any player's death costs the team a life
+void updateGame(struct GameWorld* world, int input){
+    profileBegin(PROFILE_BACKGROUND);
+    updateBackground(world);
+    profileEnd(PROFILE_BACKGROUND);
+    profileBegin(PROFILE_EXPLOSIONS);
+    updateExplosions(world);
+    profileEnd(PROFILE_EXPLOSIONS);
+    profileBegin(PROFILE_PLAYER);
+    bool respawned = false;
+    int anyInput = 0;
+    for (int p = 0; p < world->playerCount; p++){
+        anyInput |= playerInput(input, p);
+        if (world->players[p].deadTimer == 120){
+            world->players[p] = initPlayerSlot(world, p);
+            world->playerLives -= world->playerLives > 0;
+            if (world->playerLives == 0){
+                playSound(world, SOUND_GAME_OVER);
+            }
+            respawned = true;
+        }else if (world->playerLives > 0){
+            updatePlayer(world, &world->players[p], p, playerInput(input, p));
+        }
+    }
+    if (!respawned && world->playerLives <= 0){
+        gameOver(world, anyInput);     // a restart brings back whoever was still mid death too
+    }
+    profileEnd(PROFILE_PLAYER);
+    profileBegin(PROFILE_OBJECTS);
+    updateObjects(world);
+    profileEnd(PROFILE_OBJECTS);
+    profileBegin(PROFILE_ENEMY_MANAGEMENT);
+    updateEnemyManagement(world);
+    profileEnd(PROFILE_ENEMY_MANAGEMENT);
+    profileBegin(PROFILE_HUD);
+    updateHud(world);
+    profileEnd(PROFILE_HUD);
+    flushSounds(world);
+}
+
+void rememberWorldPositions(struct GameWorld* world){
+    for (int p = 0; p < world->playerCount; p++){
+        world->players[p].previousX = world->players[p].x;
+        world->players[p].previousY = world->players[p].y;
+    }
+    world->previousBackgroundOffset = world->backgroundOffset;
+    rememberPositions(&world->playerBullets);
+    rememberPositions(&world->enemyBullets);
+    rememberPositions(&world->enemies);
+    rememberParticlePositions(world);
+}
+
+#define PLAYER_TWO_TINT (Color){ 150, 200, 255, 255 }
+
+void drawGame(struct GameWorld* world){
+    drawBackground(world);
+    if (world->playerLives > 0){
+        for (int p = 0; p < world->playerCount; p++){
+            drawPlayer(&world->players[p], p == 0 ? WHITE : PLAYER_TWO_TINT);
+        }
+    }else {
+        drawGameOver();
+    }
+    drawObjects(world);
+    profileBegin(PROFILE_HUD);
+    drawHud();
+    profileEnd(PROFILE_HUD);
+}
+
+// cleared opaque, the gpu path clears to the same color with no alpha and the screen behind it fills in
+#define SOFTWARE_CLEAR_COLOR (Color){ 10, 0, 0, 255 }
+
+void renderSoftwareFrame(struct GameWorld* world){
+    double start = getTimeSeconds();
+    refreshHud(world);
+    clearFramebuffer(SOFTWARE_CLEAR_COLOR);
+    drawGame(world);
+    flushDrawQueue();
+    softwareRenderTime += getTimeSeconds() - start;
+    softwareFrames++;
+}
+
+bool saveFrame(const char* fileName){
+    Image frame = { framebuffer, screenWidth, screenHeight, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    if (!ExportImage(frame, fileName)){
+        printf("software render: can't write %s\n", fileName);
+        return false;
+    }
+    printf("software render: frame %ld saved to %s\n", softwareFrames, fileName);
+    return true;
+}
+
+// the last frame against one saved earlier with --save-frame, every pixel has to match
+bool compareWithGolden(const char* fileName){
+    if (!FileExists(fileName)){
+        printf("golden: no %s, make one with --save-frame\n", fileName);
+        return false;
+    }
+    Image golden = LoadImage(fileName);
+    ImageFormat(&golden, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (golden.width != screenWidth || golden.height != screenHeight){
+        printf("golden: %s is %ix%i, the frame is %ix%i\n", fileName, golden.width, golden.height, screenWidth, screenHeight);
+        UnloadImage(golden);
+        return false;
+    }
+    
+    const unsigned char* expected = golden.data;
+    const unsigned char* got = (const unsigned char*)framebuffer;
+    int differing = 0;
+    int largest = 0;
+    for (int i = 0; i < screenWidth * screenHeight; i++){
+        int worst = 0;
+        for (int channel = 0; channel < 4; channel++){
+            int difference = abs(expected[i * 4 + channel] - got[i * 4 + channel]);
+            worst = difference > worst ? difference : worst;
+        }
+        differing += worst > 0;
+        largest = worst > largest ? worst : largest;
+    }
+    UnloadImage(golden);
+    
+    printf("golden: %i of %i pixels differ from %s, by %i at most\n", differing, screenWidth * screenHeight, fileName, largest);
+    return differing == 0;
+}
+
+// fnv-1a over everything the simulation owns, two runs that agree on it played out the same
+unsigned int hashBytes(unsigned int hash, const void* data, int size){
+    const unsigned char* bytes = data;
+    for (int i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+unsigned int hashEntities(unsigned int hash, struct Entities* e){
+    int size = sizeof(int) * e->count;
+    hash = hashBytes(hash, &e->count, sizeof(int));
+    hash = hashBytes(hash, e->x, size);
+    hash = hashBytes(hash, e->y, size);
+    hash = hashBytes(hash, e->width, size);
+    hash = hashBytes(hash, e->height, size);
+    hash = hashBytes(hash, e->health, size);
+    hash = hashBytes(hash, e->timer, size);
+    hash = hashBytes(hash, e->steer, size);
+    hash = hashBytes(hash, e->steerDelay, size);
+    hash = hashBytes(hash, e->hitFlash, size);
+    hash = hashBytes(hash, e->enemyType, size);
+    hash = hashBytes(hash, e->ai, size);
+    hash = hashBytes(hash, e->seed, size);
+    return hash;
+}
+
+unsigned int hashParticles(struct GameWorld* world, unsigned int hash){
+    int count = particleCount(world);
+    hash = hashBytes(hash, &count, sizeof(int));
+    for (unsigned int n = world->particles.head; n != world->particles.tail; n++){
+        int i = n & (MAX_PARTICLES - 1);
+        int particle[] = { world->particles.x[i], world->particles.y[i], world->particles.age[i], world->particles.kind[i] };
+        hash = hashBytes(hash, particle, sizeof(particle));
+    }
+    return hash;
+}
+
+unsigned int worldChecksum(struct GameWorld* world){
+    unsigned int hash = 2166136261u;
+    int state[] = {
+        world->players[0].x, world->players[0].y, world->players[0].fireCooldown, world->players[0].invinciblity, world->players[0].deadTimer,
+        world->playerLives, world->playerLevel, world->killedThisLife, world->enemiesKilled, world->enemySpawnTimer, world->upgradeTimer,
+        world->emitterCount, world->fadeTimer, world->currentBackground, world->movedBackgrounds
+    };
+    hash = hashBytes(hash, state, sizeof(state));
+    for (int p = 1; p < world->playerCount; p++){
+        int other[] = { world->players[p].x, world->players[p].y, world->players[p].fireCooldown, world->players[p].invinciblity, world->players[p].deadTimer };
+        hash = hashBytes(hash, other, sizeof(other));
+    }
+    hash = hashBytes(hash, &world->backgroundSpeed, sizeof(world->backgroundSpeed));
+    hash = hashBytes(hash, &world->backgroundOffset, sizeof(world->backgroundOffset));
+    hash = hashBytes(hash, &world->randomState, sizeof(world->randomState));
+    hash = hashEntities(hash, &world->playerBullets);
+    hash = hashEntities(hash, &world->enemyBullets);
+    hash = hashEntities(hash, &world->enemies);
+    hash = hashParticles(world, hash);
+    hash = hashBytes(hash, world->emitters, sizeof(struct Emitter) * world->emitterCount);
+    return hash;
+}
+
+// runs the game loop as fast as possible without a window, reporting ticks per second.
+// input comes from a replay when one is open, otherwise nothing is pressed except restart
+void runHeadless(struct GameWorld* world, long maxTicks){
+    
+    double startTime = getTimeSeconds();
+    double reportTime = startTime;
+    long reportTicks = 0;
+    long ticks = 0;
+    
+    while (maxTicks == 0 || ticks < maxTicks){
+        int input = INPUT_RESTART;
+        if (replayFile != NULL){
+            if (replayFinished()){
+                break;
+            }
+            input = nextReplayInput();
+        }
+        recordInput(input);
+        profileFrameBegin();
+        updateGame(world, input);
+        if (softwareRender){
+            profileBegin(PROFILE_DRAW);
+            renderSoftwareFrame(world);
+            captureFrame(framebuffer, false, 1);
+            profileEnd(PROFILE_DRAW);
+        }
+        profileFrameEnd();
+        ticks++;
+        
+        double now = getTimeSeconds();
+        if (now - reportTime >= 1.0){
+            printf("tick %ld: %.0f ticks/s, %i objects, %i killed\n", ticks, (ticks - reportTicks) / (now - reportTime), countObjects(world), world->enemiesKilled);
+            reportTime = now;
+            reportTicks = ticks;
+        }
+    }
+    
+    double elapsed = getTimeSeconds() - startTime;
+    printf("headless: %ld ticks in %.3f s (%.0f ticks/s)\n", ticks, elapsed, ticks / elapsed);
+    printf("collision pair tests: %.1f per tick (%s)\n", world->collisionPairTests / (double)ticks, bruteForceCollisions ? "brute force" : "grid");
+    printf("entities: %i live, %ld spawns dropped, %ld particles overwritten\n", countObjects(world), world->droppedSpawns, world->particlesOverwritten);
+    printf("sounds: %ld triggered, %ld merged\n", soundsTriggered, soundsMerged);
+    printf("world checksum: %08x\n", worldChecksum(world));
+    if (softwareRender){
+        printf("software render: %ld frames, %.0f frames/s, %.3f ms/frame (%s blend), hud drawn %ld times\n",
+            softwareFrames, softwareFrames / softwareRenderTime, softwareRenderTime * 1000 / softwareFrames, blendKernelName(), hudRedraws);
+    }
+}
+
+// the windowed loop played out headless against a 60 Hz vblank, once reading the input
+// straight after the present like EndDrawing does and once late. the key changes are
+// synthetic and land at random times 50 to 250 ms apart, so when they happened is known
+// exactly. the software renderer stands in for drawing when the assets load
+#define LATENCY_BENCH_FRAMES 600
+
+void runLatencyPass(struct GameWorld* world, bool late){
+    const double PERIOD = 1.0 / 60;
+    unsigned int eventState = 12345;
+    int input = INPUT_FIRE;
+    double start = getTimeSeconds();
+    double nextEvent = start + randomFrom(&eventState, 50, 250) / 1000.0;
+    double vblank = start;
+    double accumulator = 0;
+    
+    seedRandom(world, 1);
+    reset(world);
+    clearLatency();
+    lateInput = late;
+    for (int frame = 0; frame < LATENCY_BENCH_FRAMES; frame++){
+        if (late){
+            waitUntil(lateInputPollTime(vblank + PERIOD));
+        }
+        double now = getTimeSeconds();
+        double changed = -1;
+        while (nextEvent <= now){
+            input ^= INPUT_LEFT | INPUT_RIGHT;
+            changed = changed < 0 ? nextEvent : changed;
+            nextEvent += randomFrom(&eventState, 50, 250) / 1000.0;
+        }
+        noteInputPoll(input, changed < 0 ? now : changed);
+        
+        accumulator += frame == 0 ? 0 : PERIOD;
+        while (accumulator >= TICK_TIME){
+            updateGame(world, input);
+            noteInputSimulated();
+            accumulator -= TICK_TIME;
+        }
+        if (softwareRender){
+            renderSoftwareFrame(world);
+        }
+        recordFrameWork(getTimeSeconds() - now);
+        
+        // a vsynced swap blocks until the next vblank
+        while (vblank <= getTimeSeconds()){
+            vblank += PERIOD;
+        }
+        waitUntil(vblank);
+        noteFramePresented(getTimeSeconds());
+    }
+}
+
+void benchLatency(struct GameWorld* world){
+    softwareRender = startSoftwareRenderer() && loadSoftwareAssets();
+    printf("input to present over %i frames at 60 Hz, %s\n", LATENCY_BENCH_FRAMES, softwareRender ? "software rendered" : "simulation only");
+    printf("%-12s %8s %8s %8s %8s %8s\n", "input", "changes", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    runLatencyPass(world, false);
+    printLatency("early");
+    runLatencyPass(world, true);
+    printLatency("late");
+    unloadSoftwareAssets();
+    stopSoftwareRenderer();
+}
+
+// random boxes through collideBoxBatch must give bit for bit what checkBoxCollisions gives,
+// counts are random too so the scalar tail after the vector loop gets exercised
+bool verifyCollisionKernel(struct GameWorld* world){
+    const int BATCHES = 100000;
+    const int MAX_BATCH = 67;
+    int xs[MAX_BATCH];
+    int ys[MAX_BATCH];
+    int ws[MAX_BATCH];
+    int hs[MAX_BATCH];
+    unsigned int mask[MASK_WORDS(MAX_BATCH)];
+    long pairs = 0;
+    
+    for (int batch = 0; batch < BATCHES; batch++){
+        int tx = gameRandom(world, -40, 260);
+        int ty = gameRandom(world, -80, 380);
+        int tw = gameRandom(world, 0, 40);
+        int th = gameRandom(world, 0, 60);
+        int count = gameRandom(world, 0, MAX_BATCH);
+        for (int i = 0; i < count; i++){
+            // small ranges so touching edges and empty boxes come up often
+            xs[i] = tx + gameRandom(world, -50, 50);
+            ys[i] = ty + gameRandom(world, -70, 70);
+            ws[i] = gameRandom(world, 0, 20);
+            hs[i] = gameRandom(world, 0, 20);
+        }
+        
+        collideBoxBatch(tx, ty, tw, th, xs, ys, ws, hs, count, mask);
+        for (int i = 0; i < count; i++){
+            bool expected = checkBoxCollisions(tx, ty, tw, th, xs[i], ys[i], ws[i], hs[i]);
+            bool got = (mask[i / 32] >> (i % 32)) & 1;
+            if (expected != got){
+                printf("collision kernel mismatch: target %i %i %i %i box %i %i %i %i\n", tx, ty, tw, th, xs[i], ys[i], ws[i], hs[i]);
+                return false;
+            }
+        }
+        // nothing may be set past the end of the batch
+        if (count % 32 != 0 && (mask[count / 32] >> (count % 32)) != 0){
+            printf("collision kernel set bits past the end of a %i box batch\n", count);
+            return false;
+        }
+        pairs += count;
+    }
+    
+    printf("%s collision kernel agrees with checkBoxCollisions on %ld random pairs\n", collisionKernelName(), pairs);
+    return true;
+}
+
+// fills the playfield with bullets and enemies and runs both collision paths on identical copies
+void benchCollisions(struct GameWorld* world){
+    const int ROUNDS = 2000;
+    const int OBJECT_COUNT = 250;
+    int xs[OBJECT_COUNT];
+    int ys[OBJECT_COUNT];
+    
+    for (int i = 0; i < OBJECT_COUNT; i++){
+        xs[i] = gameRandom(world, 0, inGameWidth - 16);
+        ys[i] = gameRandom(world, 0, inGameHeight - 16);
+    }
+    
+    for (int mode = 0; mode < 2; mode++){
+        bruteForceCollisions = mode == 0;
+        world->collisionPairTests = 0;
+        int hits = 0;
+        double elapsed = 0;
+        for (int round = 0; round < ROUNDS; round++){
+            clearObjects(world);
+            for (int i = 0; i < OBJECT_COUNT; i++){
+                if (i % 2 == 0){
+                    spawnBullet(world, xs[i], ys[i], TEAM_PLAYER);
+                }else if (i % 10 == 1){
+                    spawnBullet(world, xs[i], ys[i], TEAM_ENEMIES);
+                }else {
+                    int e = spawnEnemy(world, xs[i], i % 3 ? ENEMY_SAMUEL : ENEMY_LAMPIR, AI_DEFAULT, 1000.0f);
+                    world->enemies.y[e] = ys[i];
+                }
+            }
+            int bullets = world->playerBullets.count;
+            double start = getTimeSeconds();
+            collideObjects(world);
+            elapsed += getTimeSeconds() - start;
+            hits = bullets - world->playerBullets.count;
+        }
+        printf("%-12s %8.0f pair tests/tick %6i bullet hits %8.2f us/tick\n", bruteForceCollisions ? "brute force" : "grid", world->collisionPairTests / (double)ROUNDS, hits, elapsed * 1000000.0 / ROUNDS);
+    }
+    bruteForceCollisions = false;
+    clearObjects(world);
+}
+
+// the old array of structs record, only kept to compare the layouts against each other
+struct LegacyObject{
+    int x;
+    int y;
+    int width;
+    int height;
+    int team;
+    bool exists;
+    int type;
+    int health;
+    int internalTimer;
+    int variable1;
+    int variable2;
+    int variable3;
+    int enemyType;
+    int ai;
+};
+
+#define LEGACY_BULLET 0
+#define LEGACY_ENEMY 1
+#define LEGACY_POW 2
+#define LEGACY_EXPLOSION 3
+
+// one tick of movement and timers over the old layout, dispatching on type for every slot
+void advanceLegacyObjects(struct GameWorld* world, struct LegacyObject* objects, int count){
+    float drift = world->backgroundSpeed / 4;
+    for (int i = 0; i < count; i++){
+        struct LegacyObject* obj = &objects[i];
+        if (!obj->exists){
+            continue;
+        }
+        switch (obj->type){
+            case LEGACY_BULLET:
+                obj->y += obj->team == TEAM_PLAYER ? -5 : 3;
+                break;
+            case LEGACY_ENEMY:
+                obj->y += 1;
+                obj->internalTimer++;
+                obj->variable3 -= obj->variable3 > 0;
+                break;
+            case LEGACY_POW:
+            case LEGACY_EXPLOSION:
+                obj->internalTimer--;
+                obj->y += drift;
+                break;
+        }
+    }
+}
+
+// the same work over the entity buckets and the particle ring. particles are never
+// retired here so both layouts keep the same population for the whole run
+void advanceEntityBuckets(struct GameWorld* world){
+    int* y = world->enemyBullets.y;
+    for (int i = 0; i < world->enemyBullets.count; i++){
+        y[i] += 3;
+    }
+    y = world->playerBullets.y;
+    for (int i = 0; i < world->playerBullets.count; i++){
+        y[i] -= 5;
+    }
+    y = world->enemies.y;
+    int* timer = world->enemies.timer;
+    int* hitFlash = world->enemies.hitFlash;
+    for (int i = 0; i < world->enemies.count; i++){
+        y[i] += 1;
+        timer[i]++;
+        hitFlash[i] -= hitFlash[i] > 0;
+    }
+    
+    int firsts[2];
+    int lasts[2];
+    int spans = particleSpans(world, firsts, lasts);
+    for (int s = 0; s < spans; s++){
+        advanceParticleSpan(world, firsts[s], lasts[s], world->backgroundSpeed / 4);
+    }
+}
+
+// the branchy per-enemy update the behaviour table replaced, kept so --bench-enemies can compare against it
+void legacyUpdateSamuel(struct GameWorld* world, int worker, int i){
+    int* x = &world->enemies.x[i];
+    int* y = &world->enemies.y[i];
+    int ai = world->enemies.ai[i];
+    
+    if (*y < 100 || ai != AI_SNIPER){
+        *y += 1;
+    }
+    
+    if ((ai == AI_DIVE || ai == AI_SHOOT_DIVE) && *y > 120){
+        *y += 2;
+    }
+        
+    if (ai == AI_DEFAULT || ai == AI_SHOOT || ai == AI_SNIPER || *y < 100){
+        if ((*y % 80 == 0 && randomFrom((unsigned int*)&world->enemies.seed[i], 0, 9) <= 7) || (ai == AI_SNIPER && world->enemies.timer[i] % 100 == 0)){
+        int target = targetPlayerX(world, *x);
+        if (*x < target - 10 || *x > target + 26){
+            world->enemies.steer[i] = (*x < target) * 2 - 1;
+        }
+        
+        world->enemies.steerDelay[i] = 10;
+        
+        }
+
+        if (world->enemies.steer[i] != 0 && *y % world->enemies.steerDelay[i] == 0){
+            *x += world->enemies.steer[i];
+            world->enemies.steerDelay[i] -= world->enemies.steerDelay[i] > 1;
+        }
+    
+    }
+    world->enemies.timer[i]++;
+    if (world->enemies.timer[i] % 120 == 0 && (ai == AI_SNIPER || ai == AI_SHOOT || ai == AI_SHOOT_DIVE)){
+        pushCommand(world, worker, COMMAND_SPAWN_BULLET, *x + 6, *y + 6, TEAM_ENEMIES);
+    }
+    
+    // hit flash
+    world->enemies.hitFlash[i] -= world->enemies.hitFlash[i] > 0;
+}
+
+void copyEnemyColumns(int* to[], int* from[], int count){
+    for (int c = 0; c < 7; c++){
+        memcpy(to[c], from[c], sizeof(int) * count);
+    }
+}
+
+// the old per-enemy update against the grouped behaviour loops on the same mix of
+// ais, both have to leave every enemy the same and queue the same number of commands
+bool benchEnemies(struct GameWorld* world){
+    const int SIZES[] = { 250, 2000, 16000 };
+    const int WORK = 20000000;
+    bool same = true;
+    
+    for (int s = 0; s < 3; s++){
+        int count = SIZES[s];
+        int rounds = WORK / count;
+        clearObjects(world);
+        for (int i = 0; i < count; i++){
+            int e = spawnEnemy(world, gameRandom(world, 0, inGameWidth - 32), gameRandom(world, 0, 1) ? ENEMY_SAMUEL : ENEMY_LAMPIR, gameRandom(world, 0, AI_COUNT - 1), 1.0f);
+            world->enemies.y[e] = gameRandom(world, -60, 0);
+            world->enemies.timer[e] = gameRandom(world, 0, 119);
+        }
+        world->playerX[0] = inGameWidth / 2;
+        
+        // rounds keep restarting from the same state so nobody walks off the screen
+        int* columns[7] = { world->enemies.x, world->enemies.y, world->enemies.timer, world->enemies.steer, world->enemies.steerDelay, world->enemies.hitFlash, world->enemies.seed };
+        int* initial[7];
+        int* legacyResult[7];
+        for (int c = 0; c < 7; c++){
+            initial[c] = malloc(sizeof(int) * count);
+            legacyResult[c] = malloc(sizeof(int) * count);
+        }
+        copyEnemyColumns(initial, columns, count);
+        
+        const int TICKS = 200;
+        long legacyCommands = 0;
+        double start = getTimeSeconds();
+        for (int round = 0; round < rounds / TICKS + 1; round++){
+            copyEnemyColumns(columns, initial, count);
+            for (int tick = 0; tick < TICKS; tick++){
+                for (int i = 0; i < count; i++){
+                    if (world->enemies.health[i] <= 0){
+                        pushCommand(world, 0, COMMAND_KILL_ENEMY, i, 0, 0);
+                    }else if (isOutsidePlayfield(world->enemies.x[i], world->enemies.y[i], world->enemies.width[i], world->enemies.height[i]) || world->enemies.y[i] > inGameHeight){
+                        pushCommand(world, 0, COMMAND_REMOVE_ENEMY, i, 0, 0);
+                    }else {
+                        legacyUpdateSamuel(world, 0, i);
+                    }
+                }
+                legacyCommands += world->commandBuffers[0].count;
+                world->commandBuffers[0].count = 0;
+            }
+        }
+        double legacyTime = getTimeSeconds() - start;
+        copyEnemyColumns(legacyResult, columns, count);
+        
+        long groupedCommands = 0;
+        start = getTimeSeconds();
+        for (int round = 0; round < rounds / TICKS + 1; round++){
+            copyEnemyColumns(columns, initial, count);
+            for (int tick = 0; tick < TICKS; tick++){
+                groupEnemies(world);
+                updateEnemyRange(world, 0, 0, world->aiGroupStart[AI_COUNT]);
+                groupedCommands += world->commandBuffers[0].count;
+                world->commandBuffers[0].count = 0;
+            }
+        }
+        double groupedTime = getTimeSeconds() - start;
+        
+        bool matches = legacyCommands == groupedCommands;
+        for (int c = 0; c < 7; c++){
+            matches = matches && memcmp(legacyResult[c], columns[c], sizeof(int) * count) == 0;
+            free(initial[c]);
+            free(legacyResult[c]);
+        }
+        same = same && matches;
+        
+        double updates = (double)(rounds / TICKS + 1) * TICKS * count;
+        printf("%6i enemies: branching %6.2f ns/enemy, behaviour groups %6.2f ns/enemy (%.1fx)%s\n",
+            count,
+            legacyTime * 1000000000.0 / updates,
+            groupedTime * 1000000000.0 / updates,
+            legacyTime / groupedTime,
+            matches ? "" : ", RESULTS DIFFER");
+    }
+    
+    clearObjects(world);
+    world->playerX[0] = 0;
+    return same;
+}
+
+// random spans through the sse2 blend must give bit for bit what the scalar one gives,
+// then a busy late game frame is drawn over and over with each of them
+bool benchRaster(struct GameWorld* world){
+    const int SPANS = 100000;
+    const int MAX_SPAN = 67;
+    Color src[MAX_SPAN];
+    Color vector[MAX_SPAN];
+    Color scalar[MAX_SPAN];
+    for (int span = 0; span < SPANS; span++){
+        int count = gameRandom(world, 0, MAX_SPAN);
+        // fully transparent and fully opaque pixels come up often, they are most of every sprite
+        Color tint = { gameRandom(world, 0, 255), gameRandom(world, 0, 255), gameRandom(world, 0, 255), gameRandom(world, 0, 3) ? 255 : gameRandom(world, 0, 255) };
+        for (int i = 0; i < count; i++){
+            int alpha = gameRandom(world, 0, 2);
+            src[i] = (Color){ gameRandom(world, 0, 255), gameRandom(world, 0, 255), gameRandom(world, 0, 255), alpha == 0 ? 0 : alpha == 1 ? 255 : gameRandom(world, 0, 255) };
+            scalar[i] = (Color){ gameRandom(world, 0, 255), gameRandom(world, 0, 255), gameRandom(world, 0, 255), gameRandom(world, 0, 255) };
+            vector[i] = scalar[i];
+        }
+        scalarBlend = false;
+        blendSpan(vector, src, count, tint);
+        scalarBlend = true;
+        blendSpan(scalar, src, count, tint);
+        if (memcmp(vector, scalar, sizeof(Color) * count) != 0){
+            printf("%s blend differs from the scalar one on a %i pixel span\n", blendKernelName(), count);
+            return false;
+        }
+    }
+    scalarBlend = false;
+    printf("%s blend agrees with the scalar one on %i random spans\n", blendKernelName(), SPANS);
+    
+    seedRandom(world, 1);
+    reset(world);
+    world->enemiesKilled = 150;
+    for (int tick = 0; tick < 900; tick++){
+        updateGame(world, INPUT_FIRE | ((tick / 90) % 2 ? INPUT_LEFT : INPUT_RIGHT));
+    }
+    
+    const int FRAMES = 300;
+    Color* reference = malloc(sizeof(Color) * screenWidth * screenHeight);
+    bool same = true;
+    for (int mode = 0; mode < 2; mode++){
+        scalarBlend = mode == 1;
+        softwareFrames = 0;
+        softwareRenderTime = 0;
+        for (int frame = 0; frame < FRAMES; frame++){
+            renderSoftwareFrame(world);
+        }
+        if (mode == 0){
+            memcpy(reference, framebuffer, sizeof(Color) * screenWidth * screenHeight);
+        }else {
+            same = memcmp(reference, framebuffer, sizeof(Color) * screenWidth * screenHeight) == 0;
+        }
+        printf("%-7s %8.0f frames/s %8.3f ms/frame, %i draws, %i objects\n", blendKernelName(), FRAMES / softwareRenderTime, softwareRenderTime * 1000 / FRAMES, frameDrawCalls, countObjects(world));
+    }
+    scalarBlend = false;
+    free(reference);
+    reset(world);
+    
+    if (!same){
+        printf("the frames drawn with the two blends differ\n");
+    }
+    return same;
+}
+
+// compares a tick of movement over the old array of structs against the entity buckets
+void benchLayout(struct GameWorld* world){
+    const int SIZES[] = { 250, 2000, 20000 };
+    const int WORK = 20000000;
+    world->backgroundSpeed = 3.0f;
+    
+    for (int s = 0; s < 3; s++){
+        int count = SIZES[s];
+        int rounds = WORK / count;
+        struct LegacyObject* legacy = calloc(count, sizeof(struct LegacyObject));
+        clearObjects(world);
+        
+        // half bullets, a tenth enemies, the rest particles, shuffled like a busy pool
+        for (int i = 0; i < count; i++){
+            int roll = gameRandom(world, 0, 99);
+            struct LegacyObject* obj = &legacy[i];
+            obj->exists = true;
+            obj->x = gameRandom(world, 0, inGameWidth);
+            obj->y = gameRandom(world, 0, inGameHeight);
+            if (roll < 40){
+                obj->type = LEGACY_BULLET;
+                obj->team = TEAM_PLAYER;
+                spawnBullet(world, obj->x, obj->y, TEAM_PLAYER);
+            }else if (roll < 50){
+                obj->type = LEGACY_BULLET;
+                obj->team = TEAM_ENEMIES;
+                spawnBullet(world, obj->x, obj->y, TEAM_ENEMIES);
+            }else if (roll < 60){
+                obj->type = LEGACY_ENEMY;
+                obj->team = TEAM_ENEMIES;
+                spawnEnemy(world, obj->x, ENEMY_SAMUEL, AI_DEFAULT, 1.0f);
+            }else if (roll < 80){
+                obj->type = LEGACY_POW;
+                spawnPow(world, obj->x, obj->y);
+            }else {
+                obj->type = LEGACY_EXPLOSION;
+                obj->internalTimer = 21;
+                spawnParticle(world, PARTICLE_EXPLOSION, obj->x, obj->y);
+            }
+        }
+        
+        double start = getTimeSeconds();
+        for (int round = 0; round < rounds; round++){
+            advanceLegacyObjects(world, legacy, count);
+        }
+        double legacyTime = getTimeSeconds() - start;
+        
+        start = getTimeSeconds();
+        for (int round = 0; round < rounds; round++){
+            advanceEntityBuckets(world);
+        }
+        double bucketTime = getTimeSeconds() - start;
+        
+        printf("%6i entities: array of structs %6.2f ns/entity, buckets %6.2f ns/entity (%.1fx)\n",
+            count,
+            legacyTime * 1000000000.0 / ((double)rounds * count),
+            bucketTime * 1000000000.0 / ((double)rounds * count),
+            legacyTime / bucketTime);
+        free(legacy);
+    }
+    
+    world->backgroundSpeed = 0.0f;
+    clearObjects(world);
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Snapshots *
+//------------------------------------------------------------------------------------
+// the whole simulation as one binary blob: a header with the size of every section,
+// then the world scalars and the players, then every bucket, the particle ring and the
+// emitters. buckets only store their live entities and only the columns their kind
+// uses, anything left out restores as zero the way addEntity would leave it.
+// render only state (previous positions) is left out and restored as "not moved"
+#define SNAPSHOT_MAGIC 0x50414e53       // "SNAP"
+#define SNAPSHOT_VERSION 2
+#define SECTION_WORLD 0
+#define SECTION_PLAYER_BULLETS 1
+#define SECTION_ENEMY_BULLETS 2
+#define SECTION_ENEMIES 3
+#define SECTION_PARTICLES 4
+#define SECTION_EMITTERS 5
+#define SNAPSHOT_SECTIONS 6
+
+struct SnapshotHeader{
+    unsigned int magic;
+    int version;
+    int sectionSize[SNAPSHOT_SECTIONS];
+};
+
+struct WorldState{
+    struct Player players[MAX_PLAYERS];
+    int playerX[MAX_PLAYERS];
+    int playerY[MAX_PLAYERS];
+    int playerLevel;
+    int playerLives;
+    int killedThisLife;
+    int enemiesKilled;
+    int enemySpawnTimer;
+    int upgradeTimer;
+    int fadeTimer;
+    int currentBackground;
+    int movedBackgrounds;
+    float backgroundSpeed;
+    float backgroundOffset;
+    unsigned int randomState;
+};
+
+struct Snapshot{
+    unsigned char* data;
+    int size;
+    int capacity;
+};
+
+bool reserveSnapshot(struct Snapshot* snapshot, int size){
+    if (size <= snapshot->capacity){
+        return true;
+    }
+    int capacity = snapshot->capacity == 0 ? 4096 : snapshot->capacity;
+    while (capacity < size){
+        capacity *= 2;
+    }
+    unsigned char* grown = realloc(snapshot->data, capacity);
+    if (grown == NULL){
+        return false;
+    }
+    snapshot->data = grown;
+    snapshot->capacity = capacity;
+    return true;
+}
+
+// bullets only ever get a position and a size, enemies use every gameplay column
+#define BULLET_SNAPSHOT_COLUMNS 4
+#define ENEMY_SNAPSHOT_COLUMNS 12
+#define ENEMY_COLUMN_TYPE 9
+#define ENEMY_COLUMN_AI 10
+#define PARTICLE_SNAPSHOT_COLUMNS 4
+
+void entityColumns(struct Entities* e, int** columns){
+    int* all[ENEMY_SNAPSHOT_COLUMNS] = { e->x, e->y, e->width, e->height, e->health, e->timer, e->steer, e->steerDelay, e->hitFlash, e->enemyType, e->ai, e->seed };
+    memcpy(columns, all, sizeof(all));
+}
+
+// one record per entity so a removal moves a single record instead of shifting every column
+int writeBucket(struct Entities* e, int columnCount, unsigned char* out){
+    int* columns[ENEMY_SNAPSHOT_COLUMNS];
+    entityColumns(e, columns);
+    int* record = (int*)out;
+    for (int i = 0; i < e->count; i++){
+        for (int c = 0; c < columnCount; c++){
+            *record++ = columns[c][i];
+        }
+    }
+    return sizeof(int) * columnCount * e->count;
+}
+
+bool bucketFits(int columnCount, int size){
+    int recordSize = sizeof(int) * columnCount;
+    return size % recordSize == 0 && size / recordSize <= MAX_ENTITIES;
+}
+
+// every enemy's type and ai pick an entry out of a table
+bool enemiesFit(const unsigned char* in, int size){
+    const int* record = (const int*)in;
+    for (int i = 0; i < size / (int)(sizeof(int) * ENEMY_SNAPSHOT_COLUMNS); i++, record += ENEMY_SNAPSHOT_COLUMNS){
+        int type = record[ENEMY_COLUMN_TYPE];
+        int ai = record[ENEMY_COLUMN_AI];
+        if (type < 0 || type >= ENEMY_TYPE_COUNT || enemyArchetypes[type].width == 0 || ai < 0 || ai >= AI_COUNT){
+            return false;
+        }
+    }
+    return true;
+}
+
+// a dead particle can wait behind a live one, but never outlives the longest lived kind
+bool particlesFit(const unsigned char* in, int size){
+    int longest = 0;
+    for (int kind = 0; kind < PARTICLE_KIND_COUNT; kind++){
+        longest = particleKinds[kind].lifetime > longest ? particleKinds[kind].lifetime : longest;
+    }
+    const int* particle = (const int*)in;
+    for (int n = 0; n < size / (int)(sizeof(int) * PARTICLE_SNAPSHOT_COLUMNS); n++, particle += PARTICLE_SNAPSHOT_COLUMNS){
+        if (particle[3] < 0 || particle[3] >= PARTICLE_KIND_COUNT || particle[2] < 0 || particle[2] > longest){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool emittersFit(const unsigned char* in, int size){
+    struct Emitter emitter;
+    for (int e = 0; e < size / (int)sizeof(struct Emitter); e++){
+        memcpy(&emitter, in + e * sizeof(struct Emitter), sizeof(emitter));
+        if (emitter.timer <= 0 || emitter.timer > BIG_EXPLOSION_TICKS){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool reserveBucket(struct Entities* e, int columnCount, int size){
+    int count = size / (sizeof(int) * columnCount);
+    while (e->capacity < count){
+        if (!growEntities(e)){
+            return false;
+        }
+    }
+    return true;
+}
+
+// the bucket has to have been reserved first
+void readBucket(struct GameWorld* world, struct Entities* e, int columnCount, const unsigned char* in, int size){
+    int count = size / (sizeof(int) * columnCount);
+    e->count = 0;
+    int* columns[ENEMY_SNAPSHOT_COLUMNS];
+    const int* record = (const int*)in;
+    for (int i = 0; i < count; i++){
+        addEntity(world, e);
+        entityColumns(e, columns);
+        for (int c = 0; c < columnCount; c++){
+            columns[c][i] = *record++;
+        }
+    }
+}
+
+bool saveSnapshot(struct GameWorld* world, struct Snapshot* snapshot){
+    int bucketSizes[3] = {
+        sizeof(int) * BULLET_SNAPSHOT_COLUMNS * world->playerBullets.count,
+        sizeof(int) * BULLET_SNAPSHOT_COLUMNS * world->enemyBullets.count,
+        sizeof(int) * ENEMY_SNAPSHOT_COLUMNS * world->enemies.count,
+    };
+    struct SnapshotHeader header = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, {
+        sizeof(struct WorldState), bucketSizes[0], bucketSizes[1], bucketSizes[2],
+        sizeof(int) * PARTICLE_SNAPSHOT_COLUMNS * particleCount(world), sizeof(struct Emitter) * world->emitterCount } };
+    int size = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        size += header.sectionSize[s];
+    }
+    if (!reserveSnapshot(snapshot, size)){
+        return false;
+    }
+    
+    unsigned char* out = snapshot->data;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    
+    struct WorldState state = {
+        .playerLevel = world->playerLevel, .playerLives = world->playerLives, .killedThisLife = world->killedThisLife, .enemiesKilled = world->enemiesKilled,
+        .enemySpawnTimer = world->enemySpawnTimer, .upgradeTimer = world->upgradeTimer, .fadeTimer = world->fadeTimer, .currentBackground = world->currentBackground,
+        .movedBackgrounds = world->movedBackgrounds, .backgroundSpeed = world->backgroundSpeed, .backgroundOffset = world->backgroundOffset, .randomState = world->randomState
+    };
+    memcpy(state.players, world->players, sizeof(struct Player) * world->playerCount);
+    memcpy(state.playerX, world->playerX, sizeof(world->playerX));
+    memcpy(state.playerY, world->playerY, sizeof(world->playerY));
+    memcpy(out, &state, sizeof(state));
+    out += sizeof(state);
+    
+    out += writeBucket(&world->playerBullets, BULLET_SNAPSHOT_COLUMNS, out);
+    out += writeBucket(&world->enemyBullets, BULLET_SNAPSHOT_COLUMNS, out);
+    out += writeBucket(&world->enemies, ENEMY_SNAPSHOT_COLUMNS, out);
+    
+    int* particle = (int*)out;
+    for (unsigned int n = world->particles.head; n != world->particles.tail; n++){
+        int i = n & (MAX_PARTICLES - 1);
+        *particle++ = world->particles.x[i];
+        *particle++ = world->particles.y[i];
+        *particle++ = world->particles.age[i];
+        *particle++ = world->particles.kind[i];
+    }
+    out = (unsigned char*)particle;
+    memcpy(out, world->emitters, sizeof(struct Emitter) * world->emitterCount);
+    
+    snapshot->size = size;
+    return true;
+}
+
+// a blob that does not add up, or has a record pointing outside one of the tables, is
+// refused before anything is touched. so is one the buckets can't grow to hold, growing
+// them leaves what is in them alone
+bool restoreSnapshot(struct GameWorld* world, const struct Snapshot* snapshot){
+    struct SnapshotHeader header;
+    if (snapshot->size < (int)sizeof(header)){
+        return false;
+    }
+    memcpy(&header, snapshot->data, sizeof(header));
+    long size = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        if (header.sectionSize[s] < 0){
+            return false;
+        }
+        size += header.sectionSize[s];
+    }
+    int* sectionSize = header.sectionSize;
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || size != snapshot->size ||
+        sectionSize[SECTION_WORLD] != sizeof(struct WorldState) ||
+        !bucketFits(BULLET_SNAPSHOT_COLUMNS, sectionSize[SECTION_PLAYER_BULLETS]) ||
+        !bucketFits(BULLET_SNAPSHOT_COLUMNS, sectionSize[SECTION_ENEMY_BULLETS]) ||
+        !bucketFits(ENEMY_SNAPSHOT_COLUMNS, sectionSize[SECTION_ENEMIES]) ||
+        sectionSize[SECTION_PARTICLES] % (sizeof(int) * PARTICLE_SNAPSHOT_COLUMNS) != 0 ||
+        sectionSize[SECTION_PARTICLES] / (int)(sizeof(int) * PARTICLE_SNAPSHOT_COLUMNS) > MAX_PARTICLES ||
+        sectionSize[SECTION_EMITTERS] % sizeof(struct Emitter) != 0 || sectionSize[SECTION_EMITTERS] / (int)sizeof(struct Emitter) > MAX_EMITTERS){
+        return false;
+    }
+    
+    const unsigned char* in = snapshot->data + sizeof(header);
+    const unsigned char* sections[SNAPSHOT_SECTIONS];
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        sections[s] = in;
+        in += header.sectionSize[s];
+    }
+    if (!enemiesFit(sections[SECTION_ENEMIES], sectionSize[SECTION_ENEMIES]) ||
+        !particlesFit(sections[SECTION_PARTICLES], sectionSize[SECTION_PARTICLES]) ||
+        !emittersFit(sections[SECTION_EMITTERS], sectionSize[SECTION_EMITTERS]) ||
+        !reserveBucket(&world->playerBullets, BULLET_SNAPSHOT_COLUMNS, sectionSize[SECTION_PLAYER_BULLETS]) ||
+        !reserveBucket(&world->enemyBullets, BULLET_SNAPSHOT_COLUMNS, sectionSize[SECTION_ENEMY_BULLETS]) ||
+        !reserveBucket(&world->enemies, ENEMY_SNAPSHOT_COLUMNS, sectionSize[SECTION_ENEMIES])){
+        return false;
+    }
+    
+    readBucket(world, &world->playerBullets, BULLET_SNAPSHOT_COLUMNS, sections[SECTION_PLAYER_BULLETS], sectionSize[SECTION_PLAYER_BULLETS]);
+    readBucket(world, &world->enemyBullets, BULLET_SNAPSHOT_COLUMNS, sections[SECTION_ENEMY_BULLETS], sectionSize[SECTION_ENEMY_BULLETS]);
+    readBucket(world, &world->enemies, ENEMY_SNAPSHOT_COLUMNS, sections[SECTION_ENEMIES], sectionSize[SECTION_ENEMIES]);
+    
+    struct WorldState state;
+    memcpy(&state, sections[SECTION_WORLD], sizeof(state));
+    for (int p = 0; p < world->playerCount; p++){
+        world->players[p] = state.players[p];
+        world->players[p].previousX = world->players[p].x;
+        world->players[p].previousY = world->players[p].y;
+    }
+    memcpy(world->playerX, state.playerX, sizeof(world->playerX));
+    memcpy(world->playerY, state.playerY, sizeof(world->playerY));
+    world->playerLevel = state.playerLevel;
+    world->playerLives = state.playerLives;
+    world->killedThisLife = state.killedThisLife;
+    world->enemiesKilled = state.enemiesKilled;
+    world->enemySpawnTimer = state.enemySpawnTimer;
+    world->upgradeTimer = state.upgradeTimer;
+    world->fadeTimer = state.fadeTimer;
+    world->currentBackground = state.currentBackground;
+    world->movedBackgrounds = state.movedBackgrounds;
+    world->backgroundSpeed = state.backgroundSpeed;
+    world->backgroundOffset = state.backgroundOffset;
+    world->previousBackgroundOffset = state.backgroundOffset;
+    world->randomState = state.randomState;
+    
+    clearParticles(world);
+    const int* particle = (const int*)sections[SECTION_PARTICLES];
+    for (int n = 0; n < sectionSize[SECTION_PARTICLES] / (int)(sizeof(int) * PARTICLE_SNAPSHOT_COLUMNS); n++, particle += PARTICLE_SNAPSHOT_COLUMNS){
+        int i = spawnParticle(world, particle[3], particle[0], particle[1]);
+        world->particles.age[i] = particle[2];
+        world->particles.sprite[i] = world->particles.firstSprite[i] + ((world->particles.age[i] * world->particles.frameStep[i]) >> 8);
+    }
+    world->emitterCount = header.sectionSize[SECTION_EMITTERS] / sizeof(struct Emitter);
+    memcpy(world->emitters, sections[SECTION_EMITTERS], header.sectionSize[SECTION_EMITTERS]);
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// * Rewind *
+//------------------------------------------------------------------------------------
+// one snapshot per tick for the last REWIND_TICKS ticks. every REWIND_KEYFRAME_INTERVAL-th
+// is kept whole, the rest only as the difference to the tick before: each section is
+// xored with the same section of the previous snapshot and the zero runs that leaves
+// are squeezed out. going back rebuilds from the nearest keyframe forward
+#define REWIND_TICKS (5 * TICK_RATE)
+#define REWIND_KEYFRAME_INTERVAL 30
+
+struct RewindEntry{
+    struct Snapshot encoded;
+    bool keyframe;
+};
+
+struct RewindEntry rewindEntries[REWIND_TICKS];
+long rewindFirst = 0;           // oldest tick still in the ring
+long rewindCount = 0;
+long rewindPushed = 0;          // ticks pushed so far, decides which ones are keyframes
+struct Snapshot rewindLast;     // the newest snapshot whole, the next delta is taken against it
+struct Snapshot rewindScratch;
+struct Snapshot rewindEncoded;  // a new entry until it's known to fit, then it trades places with its slot
+struct Snapshot rewindRebuilt;  // a rewind is rebuilt here and only becomes rewindLast once it worked
+long rewindRawBytes = 0;
+long rewindStoredBytes = 0;
+
+int writeVarint(unsigned char* out, unsigned int value){
+    int n = 0;
+    while (value >= 0x80){
+        out[n++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = value;
+    return n;
+}
+
+int readVarint(const unsigned char* in, const unsigned char* end, unsigned int* value){
+    *value = 0;
+    for (int n = 0, shift = 0; in + n < end && shift < 32; n++, shift += 7){
+        *value |= (unsigned int)(in[n] & 0x7f) << shift;
+        if (!(in[n] & 0x80)){
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// (zero run, literal count, literals) triples for next xor previous, previous reads as zero past its end
+int encodeXor(const unsigned char* previous, int previousSize, const unsigned char* next, int size, unsigned char* out){
+    unsigned char* start = out;
+    int i = 0;
+    while (i < size){
+        int zeros = 0;
+        while (i + zeros < size && next[i + zeros] == (i + zeros < previousSize ? previous[i + zeros] : 0)){
+            zeros++;
+        }
+        int literals = 0;
+        // a literal run only ends at two matching bytes in a row, one costs less to copy than to break on
+        while (i + zeros + literals < size){
+            int at = i + zeros + literals;
+            bool same = next[at] == (at < previousSize ? previous[at] : 0);
+            bool nextSame = at + 1 >= size || next[at + 1] == (at + 1 < previousSize ? previous[at + 1] : 0);
+            if (same && nextSame){
+                break;
+            }
+            literals++;
+        }
+        out += writeVarint(out, zeros);
+        out += writeVarint(out, literals);
+        for (int n = 0; n < literals; n++){
+            int at = i + zeros + n;
+            *out++ = next[at] ^ (at < previousSize ? previous[at] : 0);
+        }
+        i += zeros + literals;
+    }
+    return out - start;
+}
+
+bool decodeXor(const unsigned char* previous, int previousSize, const unsigned char** in, const unsigned char* end, unsigned char* next, int size){
+    int i = 0;
+    while (i < size){
+        unsigned int zeros;
+        unsigned int literals;
+        int used = readVarint(*in, end, &zeros);
+        *in += used;
+        int usedLiterals = used == 0 ? 0 : readVarint(*in, end, &literals);
+        *in += usedLiterals;
+        if (usedLiterals == 0 || zeros > (unsigned int)(size - i) || literals > (unsigned int)(size - i) - zeros || *in + literals > end){
+            return false;
+        }
+        for (unsigned int n = 0; n < zeros + literals; n++, i++){
+            unsigned char base = i < previousSize ? previous[i] : 0;
+            next[i] = n < zeros ? base : base ^ *(*in)++;
+        }
+    }
+    return true;
+}
+
+// a delta is the new section sizes followed by one encoded stream per section
+bool encodeDelta(const struct Snapshot* previous, const struct Snapshot* next, struct Snapshot* delta){
+    // worst case every byte is a literal behind a tiny run header
+    if (!reserveSnapshot(delta, next->size * 2 + 64)){
+        return false;
+    }
+    struct SnapshotHeader previousHeader;
+    struct SnapshotHeader nextHeader;
+    memcpy(&previousHeader, previous->data, sizeof(previousHeader));
+    memcpy(&nextHeader, next->data, sizeof(nextHeader));
+    
+    unsigned char* out = delta->data;
+    memcpy(out, nextHeader.sectionSize, sizeof(nextHeader.sectionSize));
+    out += sizeof(nextHeader.sectionSize);
+    const unsigned char* previousSection = previous->data + sizeof(previousHeader);
+    const unsigned char* nextSection = next->data + sizeof(nextHeader);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        out += encodeXor(previousSection, previousHeader.sectionSize[s], nextSection, nextHeader.sectionSize[s], out);
+        previousSection += previousHeader.sectionSize[s];
+        nextSection += nextHeader.sectionSize[s];
+    }
+    delta->size = out - delta->data;
+    return true;
+}
+
+bool applyDelta(const struct Snapshot* previous, const struct Snapshot* delta, struct Snapshot* next){
+    struct SnapshotHeader previousHeader;
+    struct SnapshotHeader nextHeader = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, { 0 } };
+    memcpy(&previousHeader, previous->data, sizeof(previousHeader));
+    if (delta->size < (int)sizeof(nextHeader.sectionSize)){
+        return false;
+    }
+    memcpy(nextHeader.sectionSize, delta->data, sizeof(nextHeader.sectionSize));
+    int size = sizeof(nextHeader);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        if (nextHeader.sectionSize[s] < 0 || nextHeader.sectionSize[s] > MAX_ENTITIES * (int)sizeof(int) * ENEMY_SNAPSHOT_COLUMNS){
+            return false;
+        }
+        size += nextHeader.sectionSize[s];
+    }
+    if (!reserveSnapshot(next, size)){
+        return false;
+    }
+    
+    memcpy(next->data, &nextHeader, sizeof(nextHeader));
+    const unsigned char* in = delta->data + sizeof(nextHeader.sectionSize);
+    const unsigned char* end = delta->data + delta->size;
+    const unsigned char* previousSection = previous->data + sizeof(previousHeader);
+    unsigned char* nextSection = next->data + sizeof(nextHeader);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        if (!decodeXor(previousSection, previousHeader.sectionSize[s], &in, end, nextSection, nextHeader.sectionSize[s])){
+            return false;
+        }
+        previousSection += previousHeader.sectionSize[s];
+        nextSection += nextHeader.sectionSize[s];
+    }
+    next->size = size;
+    return in == end;
+}
+
+bool copySnapshot(struct Snapshot* to, const struct Snapshot* from){
+    if (!reserveSnapshot(to, from->size)){
+        return false;
+    }
+    memcpy(to->data, from->data, from->size);
+    to->size = from->size;
+    return true;
+}
+
+void clearRewind(){
+    rewindFirst = 0;
+    rewindCount = 0;
+    rewindPushed = 0;
+}
+
+// called after every tick. a full ring only gives up its oldest entry once the new one
+// is encoded, the slot it goes into is that entry's
+void pushRewind(struct GameWorld* world){
+    if (!saveSnapshot(world, &rewindScratch)){
+        return;
+    }
+    bool keyframe = rewindCount == 0 || rewindPushed % REWIND_KEYFRAME_INTERVAL == 0;
+    if (keyframe ? !copySnapshot(&rewindEncoded, &rewindScratch) : !encodeDelta(&rewindLast, &rewindScratch, &rewindEncoded)){
+        return;
+    }
+    if (rewindCount == REWIND_TICKS){
+        rewindFirst++;
+        rewindCount--;
+    }
+    
+    struct RewindEntry* entry = &rewindEntries[(rewindFirst + rewindCount) % REWIND_TICKS];
+    struct Snapshot encoded = entry->encoded;
+    entry->encoded = rewindEncoded;
+    rewindEncoded = encoded;
+    entry->keyframe = keyframe;
+    rewindCount++;
+    rewindPushed++;
+    rewindRawBytes += rewindScratch.size;
+    rewindStoredBytes += entry->encoded.size;
+    
+    struct Snapshot swap = rewindLast;
+    rewindLast = rewindScratch;
+    rewindScratch = swap;
+}
+
+// how far back the ring can still go, ticks before the oldest keyframe can't be rebuilt
+int rewindDepth(){
+    for (long n = 0; n < rewindCount; n++){
+        if (rewindEntries[(rewindFirst + n) % REWIND_TICKS].keyframe){
+            return rewindCount - 1 - n;
+        }
+    }
+    return 0;
+}
+
+// drops the newest ticks and puts the world back to how it was that many ticks ago.
+// when it can't, the world, the ring and rewindLast stay as they were
+bool rewindTicks(struct GameWorld* world, int ticks){
+    if (ticks <= 0 || ticks > rewindDepth()){
+        return false;
+    }
+    long target = rewindCount - 1 - ticks;
+    long key = target;
+    while (!rewindEntries[(rewindFirst + key) % REWIND_TICKS].keyframe){
+        key--;
+    }
+    
+    if (!copySnapshot(&rewindRebuilt, &rewindEntries[(rewindFirst + key) % REWIND_TICKS].encoded)){
+        return false;
+    }
+    for (long n = key + 1; n <= target; n++){
+        if (!applyDelta(&rewindRebuilt, &rewindEntries[(rewindFirst + n) % REWIND_TICKS].encoded, &rewindScratch)){
+            return false;
+        }
+        struct Snapshot swap = rewindRebuilt;
+        rewindRebuilt = rewindScratch;
+        rewindScratch = swap;
+    }
+    if (!restoreSnapshot(world, &rewindRebuilt)){
+        return false;
+    }
+    struct Snapshot swap = rewindLast;
+    rewindLast = rewindRebuilt;
+    rewindRebuilt = swap;
+    rewindPushed -= rewindCount - (target + 1);
+    rewindCount = target + 1;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------------
+// * Netplay *
+//------------------------------------------------------------------------------------
+// two players over udp. each side runs every tick straight away on its own input and a
+// guess for the other one's (whatever they pressed last), then sends its inputs for
+// every tick the peer hasn't acknowledged yet, so a lost packet is covered by the next.
+// when a real input turns out different from the guess the world is restored from the
+// snapshot taken before that tick and played forward again with what is known now.
+// a peer further behind than the rollback window makes the game wait for it.
+// the host plays player one and picks the seed
+#define NET_MAGIC 0x54454e45            // "ENET"
+#define NET_MAX_INPUTS 64               // inputs resent in every packet until acknowledged
+#define NET_INPUT_RING 256              // ticks of inputs and checksums kept around
+#define MAX_ROLLBACK 30
+#define NET_SYNC_INTERVAL 20            // ticks between checks whether this side runs ahead
+#define NET_RESIM_SAMPLES 4096
+#define NET_SHIM_PACKETS 1024
+#define NET_TIMEOUT 5.0
+
+struct NetPacket{
+    unsigned int magic;
+    unsigned int seed;
+    int tick;                   // the sender's next tick to simulate
+    int advantage;              // how many ticks the sender thinks it is ahead
+    int ackTick;                // newest of the receiver's inputs the sender has
+    int syncTick;               // newest tick the sender has a final checksum for, -1 for none
+    unsigned int syncChecksum;
+    int firstTick;              // tick of inputs[0]
+    int inputCount;
+    unsigned char inputs[NET_MAX_INPUTS];
+};
+
+// the latency and loss shim holds outgoing packets here
+struct DelayedPacket{
+    double sendAt;
+    int size;
+    struct NetPacket packet;
+};
+
+bool netplaying = false;
+int localSlot = 0;
+int rollbackWindow = 8;
+int netLatency = 0;             // ms the shim holds every outgoing packet
+int netLoss = 0;                // percent of outgoing packets the shim drops
+unsigned int shimState = 1;     // the shim rolls its own numbers, the game's have to stay in step on both sides
+#if !defined(_WIN32)
+int netSocket = -1;
+struct sockaddr_in netPeer;
+#endif
+bool netHasPeer = false;
+unsigned int netSeed = 0;
+double netLastHeard = 0;
+
+long netTick = 0;               // next tick to simulate
+unsigned char localInputs[NET_INPUT_RING];
+unsigned char remoteInputs[NET_INPUT_RING];     // real up to remoteConfirmed, guesses after it
+long remoteConfirmed = -1;
+long remoteAcked = -1;
+long remoteTick = 0;
+int remoteAdvantage = 0;
+long nextSyncCheck = 0;
+long firstWrongTick = -1;       // oldest tick that ran on a wrong guess, -1 when none did
+unsigned int tickChecksums[NET_INPUT_RING];
+long pendingSyncTick = -1;
+unsigned int pendingSyncChecksum = 0;
+long syncedTick = -1;
+struct Snapshot rollbackSnapshots[MAX_ROLLBACK + 1];    // the world before tick t sits at t % (MAX_ROLLBACK + 1)
+struct DelayedPacket delayedPackets[NET_SHIM_PACKETS];
+int delayedCount = 0;
+
+long rollbackDepths[MAX_ROLLBACK + 1];      // how many rollbacks went back that many ticks
+float resimTimes[NET_RESIM_SAMPLES];       // ms, the newest NET_RESIM_SAMPLES rollbacks
+long netRollbacks = 0;
+long rollbackFailures = 0;     // snapshots that could not be restored, the world stayed on its guess
+int lastRollbackDepth = 0;
+float lastResimTime = 0;
+long netInputStalls = 0;
+long netSyncStalls = 0;
+long packetsSent = 0;
+long packetsShimDropped = 0;
+long packetsReceived = 0;
+long syncChecks = 0;
+long desyncs = 0;
+
+#if defined(_WIN32)
+bool openNetSocket(int port){
+    return false;
+}
+
+bool setNetPeer(const char* address){
+    return false;
+}
+
+void sendDatagram(const void* data, int size){
+}
+
+int receiveDatagram(void* data, int size){
+    return -1;
+}
+
+void closeNetSocket(){
+}
+#else
+bool openNetSocket(int port){
+    netSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (netSocket < 0){
+        return false;
+    }
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    return bind(netSocket, (struct sockaddr*)&address, sizeof(address)) == 0;
+}
+
+// "ip:port"
+bool setNetPeer(const char* address){
+    char host[64];
+    const char* colon = strrchr(address, ':');
+    if (colon == NULL || colon - address >= (long)sizeof(host)){
+        return false;
+    }
+    memcpy(host, address, colon - address);
+    host[colon - address] = 0;
+    netPeer.sin_family = AF_INET;
+    netPeer.sin_port = htons(atoi(colon + 1));
+    netHasPeer = inet_pton(AF_INET, host, &netPeer.sin_addr) == 1;
+    return netHasPeer;
+}
+
+void sendDatagram(const void* data, int size){
+    if (netHasPeer){
+        sendto(netSocket, data, size, 0, (struct sockaddr*)&netPeer, sizeof(netPeer));
+    }
+}
+
+// -1 when nothing is waiting. the first one to send anything becomes the peer, later strangers are ignored
+int receiveDatagram(void* data, int size){
+    struct sockaddr_in from;
+    socklen_t fromSize = sizeof(from);
+    int received;
+    while ((received = recvfrom(netSocket, data, size, MSG_DONTWAIT, (struct sockaddr*)&from, &fromSize)) >= 0){
+        if (!netHasPeer){
+            netPeer = from;
+            netHasPeer = true;
+        }
+        if (from.sin_addr.s_addr == netPeer.sin_addr.s_addr && from.sin_port == netPeer.sin_port){
+            return received;
+        }
+        fromSize = sizeof(from);
+    }
+    return -1;
+}
+
+void closeNetSocket(){
+    if (netSocket >= 0){
+        close(netSocket);
+        netSocket = -1;
+    }
+}
+#endif
+
+unsigned int shimRandom(){
+    shimState ^= shimState << 13;
+    shimState ^= shimState >> 17;
+    shimState ^= shimState << 5;
+    return shimState;
+}
+
+void sendPacket(const struct NetPacket* packet){
+    int size = offsetof(struct NetPacket, inputs) + packet->inputCount;
+    packetsSent++;
+    if (netLoss > 0 && (int)(shimRandom() % 100) < netLoss){
+        packetsShimDropped++;
+    }else if (netLatency == 0){
+        sendDatagram(packet, size);
+    }else if (delayedCount == NET_SHIM_PACKETS){
+        packetsShimDropped++;
+    }else {
+        struct DelayedPacket* delayed = &delayedPackets[delayedCount++];
+        delayed->sendAt = getTimeSeconds() + netLatency / 1000.0;
+        delayed->size = size;
+        delayed->packet = *packet;
+    }
+}
+
+// everything waits equally long, so the oldest packet is always the next one due
+void flushDelayedPackets(){
+    double now = getTimeSeconds();
+    int sent = 0;
+    while (sent < delayedCount && delayedPackets[sent].sendAt <= now){
+        sendDatagram(&delayedPackets[sent].packet, delayedPackets[sent].size);
+        sent++;
+    }
+    memmove(delayedPackets, delayedPackets + sent, sizeof(struct DelayedPacket) * (delayedCount - sent));
+    delayedCount -= sent;
+}
+
+void sendInputs(){
+    struct NetPacket packet;
+    packet.magic = NET_MAGIC;
+    packet.seed = netSeed;
+    packet.tick = netTick;
+    packet.advantage = netTick - remoteTick;
+    packet.ackTick = remoteConfirmed;
+    // the checksums of ticks that ran on nothing but real inputs can't change any more
+    packet.syncTick = remoteConfirmed < netTick - 1 ? remoteConfirmed : netTick - 1;
+    packet.syncChecksum = packet.syncTick >= 0 ? tickChecksums[packet.syncTick % NET_INPUT_RING] : 0;
+    long first = remoteAcked + 1 > netTick - NET_MAX_INPUTS ? remoteAcked + 1 : netTick - NET_MAX_INPUTS;
+    packet.firstTick = first;
+    packet.inputCount = netTick - first;
+    for (int n = 0; n < packet.inputCount; n++){
+        packet.inputs[n] = localInputs[(first + n) % NET_INPUT_RING];
+    }
+    sendPacket(&packet);
+}
+
+bool validPacket(const struct NetPacket* packet, int size){
+    return size >= (int)offsetof(struct NetPacket, inputs) && packet->magic == NET_MAGIC &&
+        packet->inputCount >= 0 && packet->inputCount <= NET_MAX_INPUTS &&
+        size == (int)offsetof(struct NetPacket, inputs) + packet->inputCount;
+}
+
+// inputs are only taken in order, the resent ones fill any gap a lost packet left
+void handlePacket(const struct NetPacket* packet){
+    packetsReceived++;
+    netLastHeard = getTimeSeconds();
+    remoteAcked = packet->ackTick > remoteAcked ? packet->ackTick : remoteAcked;
+    if (packet->tick > remoteTick){
+        remoteTick = packet->tick;
+        remoteAdvantage = packet->advantage;
+    }
+    for (int n = 0; n < packet->inputCount; n++){
+        long tick = packet->firstTick + n;
+        if (tick != remoteConfirmed + 1){
+            continue;
+        }
+        int i = tick % NET_INPUT_RING;
+        if (tick < netTick && remoteInputs[i] != packet->inputs[n] && firstWrongTick < 0){
+            firstWrongTick = tick;
+        }
+        remoteInputs[i] = packet->inputs[n];
+        remoteConfirmed = tick;
+    }
+    if (packet->syncTick > pendingSyncTick && packet->syncTick > syncedTick){
+        pendingSyncTick = packet->syncTick;
+        pendingSyncChecksum = packet->syncChecksum;
+    }
+}
+
+void simulateNetTick(struct GameWorld* world, long tick){
+    int i = tick % NET_INPUT_RING;
+    struct Snapshot* before = &rollbackSnapshots[tick % (MAX_ROLLBACK + 1)];
+    if (!saveSnapshot(world, before)){
+        // left stale it would restore an older tick, empty it gets refused
+        before->size = 0;
+    }
+    if (tick > remoteConfirmed){
+        remoteInputs[i] = remoteConfirmed >= 0 ? remoteInputs[remoteConfirmed % NET_INPUT_RING] : 0;
+    }
+    int input = localSlot == 0 ? localInputs[i] | remoteInputs[i] << INPUT_BITS : remoteInputs[i] | localInputs[i] << INPUT_BITS;
+    updateGame(world, input);
+    tickChecksums[i] = worldChecksum(world);
+}
+
+// takes in whatever arrived and, when a guess was wrong, plays the world forward again from there
+void pollNetplay(struct GameWorld* world){
+    flushDelayedPackets();
+    struct NetPacket packet;
+    int size;
+    while ((size = receiveDatagram(&packet, sizeof(packet))) >= 0){
+        if (validPacket(&packet, size)){
+            handlePacket(&packet);
+        }
+    }
+    
+    if (firstWrongTick >= 0){
+        long long start = getTimeNanos();
+        if (restoreSnapshot(world, &rollbackSnapshots[firstWrongTick % (MAX_ROLLBACK + 1)])){
+            bool audible = world->audible;
+            world->audible = false;     // these ticks already made their sounds
+            for (long tick = firstWrongTick; tick < netTick; tick++){
+                simulateNetTick(world, tick);
+            }
+            world->audible = audible;
+            lastRollbackDepth = netTick - firstWrongTick;
+            lastResimTime = (getTimeNanos() - start) / 1000000.0f;
+            rollbackDepths[lastRollbackDepth]++;
+            resimTimes[netRollbacks % NET_RESIM_SAMPLES] = lastResimTime;
+            netRollbacks++;
+        }else {
+            // a refused restore leaves the world untouched, it plays on from the guess and the sync check will report it
+            if (rollbackFailures == 0){
+                printf("netplay: can't restore the world before tick %ld, playing on without the rollback\n", firstWrongTick);
+            }
+            rollbackFailures++;
+        }
+        firstWrongTick = -1;
+    }
+    
+    if (pendingSyncTick >= 0 && pendingSyncTick <= remoteConfirmed && pendingSyncTick < netTick){
+        if (pendingSyncTick >= netTick - NET_INPUT_RING){
+            syncChecks++;
+            if (tickChecksums[pendingSyncTick % NET_INPUT_RING] != pendingSyncChecksum){
+                if (desyncs == 0){
+                    printf("netplay: desync at tick %ld\n", pendingSyncTick);
+                }
+                desyncs++;
+            }
+        }
+        syncedTick = pendingSyncTick;
+        pendingSyncTick = -1;
+    }
+}
+
+// one tick of netplay, false when it was spent waiting on the peer instead
+bool netplayTick(struct GameWorld* world, int localInput){
+    pollNetplay(world);
+    
+    // any further ahead of the peer's inputs and a wrong guess could no longer be undone
+    if (netTick - remoteConfirmed > rollbackWindow){
+        netInputStalls++;
+        sendInputs();
+        return false;
+    }
+    // both sides see the same latency, so when one thinks it is further ahead than the
+    // other thinks it is, it runs fast and gives a tick back
+    if (netTick >= nextSyncCheck){
+        nextSyncCheck = netTick + NET_SYNC_INTERVAL;
+        if ((netTick - remoteTick) - remoteAdvantage >= 2){
+            netSyncStalls++;
+            sendInputs();
+            return false;
+        }
+    }
+    
+    localInputs[netTick % NET_INPUT_RING] = localInput;
+    rememberWorldPositions(world);
+    simulateNetTick(world, netTick);
+    netTick++;
+    sendInputs();
+    return true;
+}
+
+// the host waits for someone to show up, the joiner keeps knocking until the host
+// answers and takes the seed from its first packet
+bool startNetplay(struct GameWorld* world, const char* joinAddress, int hostPort, unsigned int* seed){
+    localSlot = joinAddress != NULL;
+    if (!openNetSocket(joinAddress != NULL ? 0 : hostPort)){
+        printf("netplay: can't open a udp socket on port %i\n", hostPort);
+        return false;
+    }
+    if (joinAddress != NULL && !setNetPeer(joinAddress)){
+        printf("netplay: %s is not an ip:port\n", joinAddress);
+        closeNetSocket();
+        return false;
+    }
+    if (rollbackWindow < 1 || rollbackWindow > MAX_ROLLBACK){
+        rollbackWindow = rollbackWindow < 1 ? 1 : MAX_ROLLBACK;
+    }
+    netSeed = *seed;
+    shimState = ((unsigned int)time(NULL) ^ (localSlot * 0x9e3779b9u)) | 1;
+    if (localSlot == 0){
+        printf("netplay: waiting for player 2 on port %i\n", hostPort);
+    }else {
+        printf("netplay: joining %s\n", joinAddress);
+    }
+    
+    double start = getTimeSeconds();
+    double lastKnock = 0;
+    while (getTimeSeconds() - start < 60.0){
+        if (localSlot == 1 && getTimeSeconds() - lastKnock > 0.1){
+            sendInputs();
+            lastKnock = getTimeSeconds();
+        }
+        flushDelayedPackets();
+        struct NetPacket packet;
+        int size = receiveDatagram(&packet, sizeof(packet));
+        if (size >= 0 && validPacket(&packet, size)){
+            if (localSlot == 1){
+                netSeed = packet.seed;
+                *seed = netSeed;
+            }
+            handlePacket(&packet);
+            world->playerCount = 2;
+            reset(world);       // spreads the players out
+            netplaying = true;
+            printf("netplay: connected as player %i, %i tick rollback window\n", localSlot + 1, rollbackWindow);
+            return true;
+        }
+        usleep(1000);
+    }
+    printf("netplay: nobody answered\n");
+    closeNetSocket();
+    return false;
+}
+
+void stopNetplay(){
+    for (int i = 0; i <= MAX_ROLLBACK; i++){
+        free(rollbackSnapshots[i].data);
+        rollbackSnapshots[i] = (struct Snapshot){ 0 };
+    }
+    closeNetSocket();
+    netplaying = false;
+}
+
+// the depth at or below which the given share of all rollbacks stayed
+int rollbackDepthPercentile(double share){
+    long seen = 0;
+    for (int depth = 0; depth <= MAX_ROLLBACK; depth++){
+        seen += rollbackDepths[depth];
+        if (seen > 0 && seen >= share * netRollbacks){
+            return depth;
+        }
+    }
+    return 0;
+}
+
+void printNetStats(){
+    int samples = netRollbacks < NET_RESIM_SAMPLES ? netRollbacks : NET_RESIM_SAMPLES;
+    struct Percentiles resim = percentiles(resimTimes, samples);
+    int maxDepth = 0;
+    for (int depth = 0; depth <= MAX_ROLLBACK; depth++){
+        maxDepth = rollbackDepths[depth] > 0 ? depth : maxDepth;
+    }
+    
+    printf("netplay: %ld ticks as player %i, %i tick window, %i ms latency and %i%% loss added on this side\n",
+        netTick, localSlot + 1, rollbackWindow, netLatency, netLoss);
+    printf("rollbacks: %ld, %ld failed to restore, depth p50 %i p99 %i max %i ticks\n",
+        netRollbacks, rollbackFailures, rollbackDepthPercentile(0.5), rollbackDepthPercentile(0.99), maxDepth);
+    if (samples > 0){
+        printf("resimulation: p50 %.3f ms, p99 %.3f ms, max %.3f ms per rollback\n",
+            resim.p50, resim.p99, resim.worst);
+    }
+    printf("stalls: %ld waiting for input, %ld for time sync\n", netInputStalls, netSyncStalls);
+    printf("packets: %ld sent, %ld dropped by the shim, %ld received\n", packetsSent, packetsShimDropped, packetsReceived);
+    printf("sync: %ld checks, %ld desyncs\n", syncChecks, desyncs);
+}
+
+// drawn on the screen next to the draw stats
+void drawNetStats(){
+    DrawText(TextFormat("NET TICK %ld, %i UNCONFIRMED, LAST ROLLBACK %i TICKS IN %.2f MS, %ld STALLS, %ld DESYNCS",
+        netTick, (int)(netTick - 1 - remoteConfirmed), lastRollbackDepth, lastResimTime, netInputStalls + netSyncStalls, desyncs),
+        10, GetScreenHeight() - 50, 10, desyncs > 0 ? ORANGE : WHITE);
+}
+
+// what a headless peer presses: always firing and changing direction at uneven times,
+// so the other side guesses wrong every now and then
+int botInput(long tick, int slot){
+    static const int moves[] = { 0, INPUT_LEFT, INPUT_RIGHT, INPUT_LEFT | INPUT_UP, INPUT_RIGHT | INPUT_DOWN };
+    unsigned int roll = (unsigned int)(tick / 15 + slot * 7919) * 2654435761u;
+    return INPUT_FIRE | INPUT_RESTART | moves[(roll >> 24) % 5];
+}
+
+// two headless instances play each other in real time. both finish on the same tick and
+// print its checksum, which has to agree once the last inputs are in
+bool runNetplayHeadless(struct GameWorld* world, long maxTicks){
+    maxTicks = maxTicks > 0 ? maxTicks : 60 * TICK_RATE;
+    
+    double nextTick = getTimeSeconds();
+    while (netTick < maxTicks){
+        double now = getTimeSeconds();
+        if (now - netLastHeard > NET_TIMEOUT){
+            printf("netplay: nothing from the peer for %.0f s\n", NET_TIMEOUT);
+            return false;
+        }
+        if (now < nextTick){
+            usleep(500);
+            continue;
+        }
+        nextTick += TICK_TIME;
+        netplayTick(world, botInput(netTick, localSlot));
+    }
+    
+    // the last ticks may still run on guesses. wait for the peer's last inputs and until it
+    // has all of ours, then keep sending a little longer so it hears that we are done too
+    double settled = 0;
+    while (settled == 0 || getTimeSeconds() - settled < 0.5){
+        pollNetplay(world);
+        sendInputs();
+        if (settled == 0 && remoteConfirmed >= maxTicks - 1 && remoteAcked >= maxTicks - 1){
+            settled = getTimeSeconds();
+        }
+        if (settled == 0 && getTimeSeconds() - netLastHeard > NET_TIMEOUT){
+            printf("netplay: the peer went away before the end\n");
+            return false;
+        }
+        usleep((int)(TICK_TIME * 1000000));
+    }
+    while (delayedCount > 0){
+        flushDelayedPackets();
+        usleep(1000);
+    }
+    
+    printNetStats();
+    printf("world checksum: %08x\n", worldChecksum(world));
+    return desyncs == 0;
+}
+
+
+//------------------------------------------------------------------------------------
+// * Batch games *
+//------------------------------------------------------------------------------------
+// thousands of headless bot games at once, one world per thread and no sound, drawing
+// or worker pool. the bot never restarts, so every game ends on its last life and the
+// per minute table shows how updateEnemyManagement ramps up against a player that
+// never gets any better. game n is always seeded with seed + n, so the batch checksum
+// only depends on the seed and the number of games, not on the threads
+#define BATCH_MINUTES 30                    // games still going after this long get stopped
+#define BATCH_MINUTE_TICKS (60 * TICK_RATE)
+
+struct BatchMinute{
+    long games;         // games still going when the minute started
+    long kills;
+    long deaths;
+    long gameOvers;
+    long enemyTicks;    // live enemies summed over every tick, for the average
+};
+
+struct BatchThread{
+    pthread_t thread;
+    int firstGame;
+    int lastGame;
+    unsigned int seed;
+    bool failed;
+    long ticks;
+    double seconds;
+    float* lengths;             // seconds each game lasted, indexed by game
+    float* kills;               // enemies killed by the end of each game
+    unsigned int* checksums;    // world checksum at the end of each game
+    struct BatchMinute minutes[BATCH_MINUTES];
+};
+
+// lines up under the lowest enemy and keeps firing, weaving when there is nothing to shoot
+int batchBotInput(struct GameWorld* world, long tick){
+    struct Player* player = &world->players[0];
+    int target = -1;
+    for (int i = 0; i < world->enemies.count; i++){
+        if (world->enemies.y[i] >= 0 && (target < 0 || world->enemies.y[i] > world->enemies.y[target])){
+            target = i;
+        }
+    }
+    int aim = target < 0 ? 0 : world->enemies.x[target] + world->enemies.width[target] / 2 - (player->x + 8);
+    int input = INPUT_FIRE | (aim < -4 ? INPUT_LEFT : 0) | (aim > 4 ? INPUT_RIGHT : 0);
+    
+    // anything about to land wins over aiming, step out from under it towards the roomier side
+    struct Entities* threats[] = { &world->enemyBullets, &world->enemies };
+    for (int t = 0; t < 2; t++){
+        struct Entities* e = threats[t];
+        for (int i = 0; i < e->count; i++){
+            int dy = player->y - (e->y[i] + e->height[i]);
+            if (dy > -e->height[i] - 16 && dy < 40 && e->x[i] < player->x + 20 && e->x[i] + e->width[i] > player->x - 4){
+                int left = player->x + 8 - (e->x[i] + e->width[i] / 2) < 0;
+                left = player->x < 40 ? 0 : player->x > inGameWidth - 56 ? 1 : left;
+                return INPUT_FIRE | (left ? INPUT_LEFT : INPUT_RIGHT);
+            }
+        }
+    }
+    return input;
+}
+
+void* batchMain(void* argument){
+    struct BatchThread* batch = argument;
+    struct GameWorld* world = createWorld();
+    if (world == NULL){
+        batch->failed = true;
+        return NULL;
+    }
+    world->audible = false;
+    
+    double start = getTimeSeconds();
+    for (int game = batch->firstGame; game < batch->lastGame; game++){
+        seedRandom(world, batch->seed + game);
+        reset(world);
+        long tick = 0;
+        int lives = world->playerLives;
+        while (world->playerLives > 0 && tick < BATCH_MINUTES * BATCH_MINUTE_TICKS){
+            struct BatchMinute* minute = &batch->minutes[tick / BATCH_MINUTE_TICKS];
+            minute->games += tick % BATCH_MINUTE_TICKS == 0;
+            int killed = world->enemiesKilled;
+            updateGame(world, batchBotInput(world, tick));
+            minute->kills += world->enemiesKilled - killed;
+            minute->deaths += world->playerLives < lives;
+            minute->gameOvers += world->playerLives <= 0;
+            minute->enemyTicks += world->enemies.count;
+            lives = world->playerLives;
+            tick++;
+        }
+        batch->ticks += tick;
+        batch->lengths[game] = tick / (float)TICK_RATE;
+        batch->kills[game] = world->enemiesKilled;
+        batch->checksums[game] = worldChecksum(world);
+    }
+    batch->seconds = getTimeSeconds() - start;
+    
+    destroyWorld(world);
+    return NULL;
+}
+
+// plays games split evenly over threads and prints ticks/s for each thread and the curve
+bool runBatch(int games, int threads, unsigned int seed){
+    threads = threads < 1 ? 1 : min(threads, games);
+    struct BatchThread* batches = calloc(threads, sizeof(struct BatchThread));
+    float* lengths = malloc(sizeof(float) * games);
+    float* kills = malloc(sizeof(float) * games);
+    unsigned int* checksums = malloc(sizeof(unsigned int) * games);
+    if (batches == NULL || lengths == NULL || kills == NULL || checksums == NULL){
+        printf("batch: not enough memory for %i games\n", games);
+        free(batches);
+        free(lengths);
+        free(kills);
+        free(checksums);
+        return false;
+    }
+    
+    headless = true;
+    profilerEnabled = false;
+    double start = getTimeSeconds();
+    int started = 0;
+    for (int t = 0; t < threads; t++){
+        struct BatchThread* batch = &batches[t];
+        batch->firstGame = (int)((long)games * t / threads);
+        batch->lastGame = (int)((long)games * (t + 1) / threads);
+        batch->seed = seed;
+        batch->lengths = lengths;
+        batch->kills = kills;
+        batch->checksums = checksums;
+        if (pthread_create(&batch->thread, NULL, batchMain, batch) != 0){
+            printf("batch: could not start thread %i\n", t);
+            break;
+        }
+        started++;
+    }
+    
+    bool passed = started == threads;
+    long ticks = 0;
+    for (int t = 0; t < started; t++){
+        pthread_join(batches[t].thread, NULL);
+        passed = passed && !batches[t].failed;
+        ticks += batches[t].ticks;
+    }
+    double elapsed = getTimeSeconds() - start;
+    if (!passed){
+        printf("batch: a thread failed, no results\n");
+        free(batches);
+        free(lengths);
+        free(kills);
+        free(checksums);
+        return false;
+    }
+    
+    printf("batch: %i games from seed %u on %i threads, %ld ticks in %.2f s (%.0f ticks/s)\n",
+        games, seed, threads, ticks, elapsed, ticks / elapsed);
+    printf("%-8s %8s %12s %12s\n", "thread", "games", "ticks", "ticks/s");
+    for (int t = 0; t < threads; t++){
+        printf("%-8i %8i %12ld %12.0f\n", t, batches[t].lastGame - batches[t].firstGame, batches[t].ticks, batches[t].ticks / batches[t].seconds);
+    }
+    printf("%-8s %8s %12s %12.0f\n", "per core", "", "", ticks / elapsed / threads);
+    
+    unsigned int checksum = hashBytes(2166136261u, checksums, sizeof(unsigned int) * games);
+    
+    // the curve, minute by minute over the games that lasted that long
+    printf("\n%-8s %8s %10s %10s %12s %12s\n", "minute", "games", "kills/min", "enemies", "deaths/game", "game overs");
+    for (int m = 0; m < BATCH_MINUTES; m++){
+        struct BatchMinute total = { 0 };
+        for (int t = 0; t < threads; t++){
+            total.games += batches[t].minutes[m].games;
+            total.kills += batches[t].minutes[m].kills;
+            total.deaths += batches[t].minutes[m].deaths;
+            total.gameOvers += batches[t].minutes[m].gameOvers;
+            total.enemyTicks += batches[t].minutes[m].enemyTicks;
+        }
+        if (total.games == 0){
+            break;
+        }
+        // the last minute of a game is cut short, so rates are over the ticks actually played
+        long gameTicks = 0;
+        for (int game = 0; game < games; game++){
+            int played = (int)(lengths[game] * TICK_RATE + 0.5f) - m * BATCH_MINUTE_TICKS;
+            gameTicks += played < 0 ? 0 : min(played, BATCH_MINUTE_TICKS);
+        }
+        printf("%-8i %8ld %10.2f %10.2f %12.3f %12ld\n", m, total.games,
+            total.kills * (double)BATCH_MINUTE_TICKS / gameTicks,
+            total.enemyTicks / (double)gameTicks,
+            total.deaths * (double)BATCH_MINUTE_TICKS / gameTicks,
+            total.gameOvers);
+    }
+    
+    struct Percentiles length = percentiles(lengths, games);
+    struct Percentiles kill = percentiles(kills, games);
+    printf("\ngame length p10 %.0f s p50 %.0f s p90 %.0f s, kills p10 %.0f p50 %.0f p90 %.0f\n",
+        length.p10, length.p50, length.p90, kill.p10, kill.p50, kill.p90);
+    printf("batch checksum: %08x\n", checksum);
+    
+    free(batches);
+    free(lengths);
+    free(kills);
+    free(checksums);
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------------
+// * Benchmark scenarios *
+//------------------------------------------------------------------------------------
+// named headless workloads that run a fixed number of ticks from the same seed,
+// so numbers from two builds can be compared line by line
+struct BenchScenario{
+    const char* name;
+    long ticks;
+    void (*setup)(struct GameWorld* world);
+    int (*tick)(struct GameWorld* world, long tick);    // prepares the tick and returns its input
+};
+
+void setupNothing(struct GameWorld* world){
+}
+
+// keeps the bullet buckets topped up to MAX_ENTITIES with tough snipers parked on screen to hit
+void setupFullPool(struct GameWorld* world){
+    for (int i = 0; i < 60; i++){
+        int e = spawnEnemy(world, gameRandom(world, 0, inGameWidth - 32), ENEMY_SAMUEL, AI_SNIPER, 1000.0f);
+        world->enemies.y[e] = gameRandom(world, 0, 90);
+    }
+}
+
+int tickFullPool(struct GameWorld* world, long tick){
+    while (world->playerBullets.count < MAX_ENTITIES){
+        spawnBullet(world, gameRandom(world, 0, inGameWidth - 16), gameRandom(world, 20, inGameHeight), TEAM_PLAYER);
+    }
+    while (world->enemyBullets.count < MAX_ENTITIES / 4){
+        spawnBullet(world, gameRandom(world, 0, inGameWidth - 16), gameRandom(world, 0, inGameHeight - 20), TEAM_ENEMIES);
+    }
+    return INPUT_RESTART;
+}
+
+// forty lampirs die together every five seconds, each one setting off a big explosion
+int tickLampirWave(struct GameWorld* world, long tick){
+    if (tick % 300 == 0){
+        for (int i = 0; i < 40; i++){
+            int e = spawnEnemy(world, gameRandom(world, 0, inGameWidth - 32), ENEMY_LAMPIR, AI_DEFAULT, 1.0f);
+            world->enemies.y[e] = gameRandom(world, 0, inGameHeight - 100);
+            world->enemies.health[e] = 0;
+        }
+    }
+    return INPUT_RESTART;
+}
+
+// spawn rates past 120 kills, with a bot weaving and firing the whole time
+int tickLateGame(struct GameWorld* world, long tick){
+    if (world->enemiesKilled < 150){
+        world->enemiesKilled = 150;
+    }
+    int input = INPUT_FIRE | INPUT_RESTART;
+    input |= (tick / 90) % 2 ? INPUT_LEFT : INPUT_RIGHT;
+    return input;
+}
+
+// thousands of parked snipers under constant fire, big enough for the enemy jobs to go wide
+void setupSwarm(struct GameWorld* world){
+    for (int i = 0; i < 4000; i++){
+        int e = spawnEnemy(world, gameRandom(world, 0, inGameWidth - 32), ENEMY_SAMUEL, AI_SNIPER, 1000.0f);
+        world->enemies.y[e] = gameRandom(world, 0, 90);
+    }
+}
+
+int tickSwarm(struct GameWorld* world, long tick){
+    while (world->playerBullets.count < 2048){
+        spawnBullet(world, gameRandom(world, 0, inGameWidth - 16), gameRandom(world, 20, inGameHeight), TEAM_PLAYER);
+    }
+    return INPUT_RESTART;
+}
+
+int tickIdle(struct GameWorld* world, long tick){
+    return INPUT_RESTART;
+}
+
+struct BenchScenario benchScenarios[] = {
+    { "full-pool", 2000, setupFullPool, tickFullPool },
+    { "lampir-wave", 3000, setupNothing, tickLampirWave },
+    { "late-game", 20000, setupNothing, tickLateGame },
+    { "swarm", 1000, setupSwarm, tickSwarm },
+    { "idle", 200000, setupNothing, tickIdle },
+};
+#define BENCH_SCENARIO_COUNT (int)(sizeof(benchScenarios) / sizeof(benchScenarios[0]))
+
+void runBenchScenario(struct GameWorld* world, struct BenchScenario* scenario){
+    float* tickTimes = malloc(sizeof(float) * scenario->ticks);
+    
+    seedRandom(world, 1);
+    reset(world);
+    scenario->setup(world);
+    int peakEntities = countObjects(world);
+    double total = 0;
+    
+    for (long tick = 0; tick < scenario->ticks; tick++){
+        int input = scenario->tick(world, tick);
+        long long start = getTimeNanos();
+        updateGame(world, input);
+        long long end = getTimeNanos();
+        
+        tickTimes[tick] = (end - start) / 1000.0f;
+        total += end - start;
+        int entities = countObjects(world);
+        peakEntities = entities > peakEntities ? entities : peakEntities;
+    }
+    
+    struct Percentiles tickTime = percentiles(tickTimes, scenario->ticks);
+    printf("%-12s %8ld %12.0f %10.2f %10.2f %10.2f %8i %08x\n",
+        scenario->name,
+        scenario->ticks,
+        scenario->ticks / (total / 1000000000.0),
+        total / 1000.0 / scenario->ticks,
+        tickTime.p50,
+        tickTime.p99,
+        peakEntities,
+        worldChecksum(world));
+    free(tickTimes);
+}
+
+// runs one scenario by name, or all of them for "all"
+bool runBenchmarks(struct GameWorld* world, const char* name){
+    bool found = false;
+    printf("%-12s %8s %12s %10s %10s %10s %8s %8s\n", "scenario", "ticks", "ticks/s", "mean us", "p50 us", "p99 us", "peak", "checksum");
+    for (int i = 0; i < BENCH_SCENARIO_COUNT; i++){
+        if (strcmp(name, "all") == 0 || strcmp(name, benchScenarios[i].name) == 0){
+            runBenchScenario(world, &benchScenarios[i]);
+            found = true;
+        }
+    }
+    
+    if (!found){
+        printf("unknown scenario %s, pick one of:", name);
+        for (int i = 0; i < BENCH_SCENARIO_COUNT; i++){
+            printf(" %s", benchScenarios[i].name);
+        }
+        printf("\n");
+    }
+    return found;
+}
+
+// breaks one table index at a time in a copy of the saved world, every copy has to be
+// refused with the world left as it was. refused counts the copies, a world with no
+// enemies, particles or emitters has nothing to break
+bool refusesCorruptSnapshots(struct GameWorld* world, const struct Snapshot* snapshot, int* refused){
+    struct SnapshotHeader header;
+    memcpy(&header, snapshot->data, sizeof(header));
+    int offsets[SNAPSHOT_SECTIONS];
+    int offset = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++){
+        offsets[s] = offset;
+        offset += header.sectionSize[s];
+    }
+    
+    // section, byte in its first record, a value outside the table
+    const int corruptions[][3] = {
+        { SECTION_ENEMIES, sizeof(int) * ENEMY_COLUMN_AI, AI_COUNT },
+        { SECTION_ENEMIES, sizeof(int) * ENEMY_COLUMN_TYPE, ENEMY_TYPE_COUNT },
+        { SECTION_ENEMIES, sizeof(int) * ENEMY_COLUMN_TYPE, -1 },
+        { SECTION_PARTICLES, sizeof(int) * 3, PARTICLE_KIND_COUNT },
+        { SECTION_PARTICLES, sizeof(int) * 2, -1 },
+        { SECTION_EMITTERS, offsetof(struct Emitter, timer), 0 },
+    };
+    struct Snapshot broken = { 0 };
+    unsigned int before = worldChecksum(world);
+    bool untouched = true;
+    *refused = 0;
+    for (int c = 0; c < (int)(sizeof(corruptions) / sizeof(corruptions[0])); c++){
+        if (header.sectionSize[corruptions[c][0]] == 0){
+            continue;
+        }
+        copySnapshot(&broken, snapshot);
+        memcpy(broken.data + offsets[corruptions[c][0]] + corruptions[c][1], &corruptions[c][2], sizeof(int));
+        if (restoreSnapshot(world, &broken) || worldChecksum(world) != before){
+            untouched = false;
+        }else {
+            (*refused)++;
+        }
+    }
+    free(broken.data);
+    return untouched;
+}
+
+// plays a few ticks on, breaks the entry a one tick rewind would land on and checks the
+// rewind is refused without touching the world. the push after it has to be taken against
+// the real last tick, or rewinding onto that push later lands somewhere else
+bool rewindSurvivesBrokenEntry(struct GameWorld* world, struct BenchScenario* scenario, long tick){
+    unsigned int played[3];
+    for (int t = 0; t < 3; t++){
+        updateGame(world, scenario->tick(world, tick + t));
+        pushRewind(world);
+        played[t] = worldChecksum(world);
+    }
+    struct RewindEntry* entry = &rewindEntries[(rewindFirst + rewindCount - 2) % REWIND_TICKS];
+    int size = entry->encoded.size;
+    entry->encoded.size = 1;
+    bool survived = !rewindTicks(world, 1) && worldChecksum(world) == played[2];
+    entry->encoded.size = size;
+    
+    updateGame(world, scenario->tick(world, tick + 3));
+    pushRewind(world);
+    unsigned int next = worldChecksum(world);
+    updateGame(world, scenario->tick(world, tick + 4));
+    pushRewind(world);
+    return rewindTicks(world, 1) && worldChecksum(world) == next && survived;
+}
+
+// every scenario pushes a rewind snapshot each tick, then the final world is saved and
+// restored over and over. a restore has to hash the same as the world it came from,
+// play on to the same checksum as the first time round, and rewinding all the way
+// back has to land on the checksum that tick had
+bool benchSnapshots(struct GameWorld* world){
+    const int ROUNDS = 200;
+    const int REPLAY_TICKS = 120;
+    bool same = true;
+    struct Snapshot snapshot = { 0 };
+    printf("%-12s %10s %10s %8s %10s %10s %10s %8s %10s %8s %6s\n",
+        "scenario", "raw bytes", "stored", "ratio", "push us", "save us", "restore us", "rewind", "rewind us", "refused", "same");
+    for (int s = 0; s < BENCH_SCENARIO_COUNT; s++){
+        struct BenchScenario* scenario = &benchScenarios[s];
+        long ticks = scenario->ticks < 3000 ? scenario->ticks : 3000;
+        unsigned int* checksums = malloc(sizeof(unsigned int) * ticks);
+        
+        seedRandom(world, 1);
+        reset(world);
+        clearRewind();
+        rewindRawBytes = 0;
+        rewindStoredBytes = 0;
+        scenario->setup(world);
+        long long pushTime = 0;
+        for (long tick = 0; tick < ticks; tick++){
+            updateGame(world, scenario->tick(world, tick));
+            long long start = getTimeNanos();
+            pushRewind(world);
+            pushTime += getTimeNanos() - start;
+            checksums[tick] = worldChecksum(world);
+        }
+        
+        long long saveTime = 0;
+        long long restoreTime = 0;
+        bool restored = true;
+        for (int r = 0; r < ROUNDS; r++){
+            long long start = getTimeNanos();
+            saveSnapshot(world, &snapshot);
+            long long saved = getTimeNanos();
+            restored = restoreSnapshot(world, &snapshot) && restored;
+            long long end = getTimeNanos();
+            saveTime += saved - start;
+            restoreTime += end - saved;
+        }
+        restored = restored && worldChecksum(world) == checksums[ticks - 1];
+        int refused;
+        restored = refusesCorruptSnapshots(world, &snapshot, &refused) && restored;
+        
+        // same inputs from the same snapshot have to play out the same
+        unsigned int replayed[2];
+        for (int pass = 0; pass < 2; pass++){
+            restored = restoreSnapshot(world, &snapshot) && restored;
+            for (long tick = ticks; tick < ticks + REPLAY_TICKS; tick++){
+                updateGame(world, scenario->tick(world, tick));
+            }
+            replayed[pass] = worldChecksum(world);
+        }
+        restored = restored && replayed[0] == replayed[1];
+        
+        // the replays went past the ring, put the world back on its last pushed tick first
+        restored = restoreSnapshot(world, &snapshot) && restored;
+        int depth = rewindDepth();
+        long long start = getTimeNanos();
+        restored = rewindTicks(world, depth) && restored;
+        long long rewindTime = getTimeNanos() - start;
+        restored = restored && worldChecksum(world) == checksums[ticks - 1 - depth];
+        restored = rewindSurvivesBrokenEntry(world, scenario, ticks) && restored;
+        
+        printf("%-12s %10.0f %10.0f %7.1fx %10.2f %10.2f %10.2f %8i %10.0f %8i %6s\n",
+            scenario->name,
+            rewindRawBytes / (double)ticks,
+            rewindStoredBytes / (double)ticks,
+            rewindRawBytes / (double)rewindStoredBytes,
+            pushTime / 1000.0 / ticks,
+            saveTime / 1000.0 / ROUNDS,
+            restoreTime / 1000.0 / ROUNDS,
+            depth,
+            rewindTime / 1000.0,
+            refused,
+            restored ? "yes" : "NO");
+        same = same && restored;
+        free(checksums);
+    }
+    free(snapshot.data);
+    return same;
+}
+
+
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+
+
+// the overlay toggles, F2 for the stats along the bottom and F3 for the profiler
+void handleOverlayKeys(){
+    if (IsKeyPressed(KEY_F2)){
+        showDrawStats = !showDrawStats;
+    }
+    if (IsKeyPressed(KEY_F3)){
+        showProfiler = !showProfiler;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double launchTime = getTimeSeconds();
+    struct GameWorld* world = createWorld();
+    if (world == NULL){
+        printf("not enough memory for the game world\n");
+        return 1;
+    }
+    
+    // Arguments
+    //--------------------------------------------------------------------------------------
+    long maxTicks = 0;
+    int targetFps = -1;
+    unsigned int seed = (unsigned int)time(NULL);
+    const char* recordPath = NULL;
+    const char* profilePath = NULL;
+    const char* saveFramePath = NULL;
+    const char* goldenPath = NULL;
+    const char* capturePath = NULL;
+    const char* joinAddress = NULL;
+    int hostPort = 0;
+    int threads = defaultWorkerCount();
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--headless") == 0){
+            headless = true;
+        }else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc){
+            maxTicks = atol(argv[++i]);
+        }else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        }else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+            profilePath = argv[++i];
+        }else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc){
+            recordPath = argv[++i];
+        }else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc){
+            if (!startReplay(argv[++i], &seed)){
+                return 1;
+            }
+            headless = true;
+        }else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc){
+            targetFps = atoi(argv[++i]);
+        }else if (strcmp(argv[i], "--early-input") == 0){
+            lateInput = false;
+        }else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc){
+            frameBudget = (float)atof(argv[++i]);
+        }else if (strcmp(argv[i], "--music-ring") == 0 && i + 1 < argc){
+            // rounded up to a power of two
+            int frames = atoi(argv[++i]);
+            musicRingFrames = 512;
+            while (musicRingFrames < frames && musicRingFrames < MUSIC_RING_MAX_FRAMES){
+                musicRingFrames *= 2;
+            }
+        }else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+        }else if (strcmp(argv[i], "--pack-assets") == 0){
+            return packAssets(i + 1 < argc ? argv[i + 1] : ASSET_PACK_FILE) ? 0 : 1;
+        }else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc){
+            hostPort = atoi(argv[++i]);
+        }else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc){
+            joinAddress = argv[++i];
+        }else if (strcmp(argv[i], "--rollback") == 0 && i + 1 < argc){
+            rollbackWindow = atoi(argv[++i]);
+        }else if (strcmp(argv[i], "--net-latency") == 0 && i + 1 < argc){
+            netLatency = atoi(argv[++i]);
+        }else if (strcmp(argv[i], "--net-loss") == 0 && i + 1 < argc){
+            netLoss = atoi(argv[++i]);
+        }else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc){
+            capturePath = argv[++i];
+        }else if (strcmp(argv[i], "--software-render") == 0){
+            softwareRender = true;
+        }else if (strcmp(argv[i], "--save-frame") == 0 && i + 1 < argc){
+            saveFramePath = argv[++i];
+            softwareRender = true;
+            headless = true;
+        }else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc){
+            goldenPath = argv[++i];
+            softwareRender = true;
+            headless = true;
+        }else if (strcmp(argv[i], "--bench-raster") == 0){
+            softwareRender = true;
+            bool same = startSoftwareRenderer() && loadSoftwareAssets() && benchRaster(world);
+            unloadSoftwareAssets();
+            stopSoftwareRenderer();
+            return same ? 0 : 1;
+        }else if (strcmp(argv[i], "--brute-collisions") == 0){
+            bruteForceCollisions = true;
+        }else if (strcmp(argv[i], "--bench-collisions") == 0){
+            if (!verifyCollisionKernel(world)){
+                return 1;
+            }
+            benchCollisions(world);
+            return 0;
+        }else if (strcmp(argv[i], "--bench-enemies") == 0){
+            return benchEnemies(world) ? 0 : 1;
+        }else if (strcmp(argv[i], "--bench-snapshot") == 0){
+            headless = true;
+            profilerEnabled = false;
+            startWorkers(threads);
+            bool same = benchSnapshots(world);
+            stopWorkers();
+            return same ? 0 : 1;
+        }else if (strcmp(argv[i], "--bench-latency") == 0){
+            headless = true;
+            profilerEnabled = false;
+            benchLatency(world);
+            return 0;
+        }else if (strcmp(argv[i], "--bench-audio") == 0){
+            headless = true;
+            return benchAudio() ? 0 : 1;
+        }else if (strcmp(argv[i], "--bench-layout") == 0){
+            benchLayout(world);
+            return 0;
+        }else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc){
+            return runBatch(atoi(argv[++i]), threads, seed) ? 0 : 1;
+        }else if (strcmp(argv[i], "--bench") == 0){
+            headless = true;
+            profilerEnabled = false;
+            startWorkers(threads);
+            printf("threads: %i\n", workerCount);
+            bool found = runBenchmarks(world, i + 1 < argc ? argv[i + 1] : "all");
+            printWorkerStats();
+            stopWorkers();
+            return found ? 0 : 1;
+        }else {
+            printf("usage: %s [--headless] [--ticks N] [--seed N] [--threads N] [--record FILE] [--replay FILE]\n"
+                   "          [--fps N, 0 for uncapped, vsync when left out]\n"
+                   "          [--frame-budget MS, 0 keeps every effect whatever the frame costs] [--early-input]\n"
+                   "          [--music-ring FRAMES, more survives longer audio stalls]\n"
+                   "          [--profile FILE.csv|FILE.jsonl]\n"
+                   "          [--host PORT | --join IP:PORT] [--rollback TICKS] [--net-latency MS] [--net-loss PERCENT]\n"
+                   "          [--software-render] [--save-frame FILE.png] [--golden FILE.png]\n"
+                   "          [--capture FILE.y4m|frame%%05d.png]\n"
+                   "          [--brute-collisions] [--bench-collisions] [--bench-layout] [--bench-enemies] [--bench-raster]\n"
+                   "          [--bench-snapshot] [--bench-latency] [--bench-audio]\n"
+                   "          [--bench [SCENARIO]]\n"
+                   "          [--batch GAMES, after --threads and --seed]\n"
+                   "          [--pack-assets [FILE]]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (hostPort != 0 || joinAddress != NULL){
+        // a recording only has room for one player's input
+        if (recordPath != NULL || replayFile != NULL){
+            printf("netplay: can't record or replay a netplay game\n");
+            return 1;
+        }
+        if (!startNetplay(world, joinAddress, hostPort, &seed)){
+            return 1;
+        }
+    }
+    
+    printf("seed: %u\n", seed);
+    seedRandom(world, seed);
+    startWorkers(threads);
+    printf("threads: %i\n", workerCount);
+    if (recordPath != NULL && !startRecording(recordPath, seed)){
+        return 1;
+    }
+    
+    if (profilePath != NULL && !startProfileLog(profilePath)){
+        return 1;
+    }
+    
+    // headless frames only exist in the software framebuffer
+    softwareRender = softwareRender || (capturePath != NULL && headless);
+    if (softwareRender && !startSoftwareRenderer()){
+        return 1;
+    }
+    if (capturePath != NULL && !startCapture(capturePath, TICK_RATE)){
+        return 1;
+    }
+    
+    if (headless){
+        if (softwareRender && !loadSoftwareAssets()){
+            return 1;
+        }
+        profilerEnabled = profileFile != NULL;
+        bool passed = true;
+        if (netplaying){
+            passed = runNetplayHeadless(world, maxTicks);
+        }else {
+            runHeadless(world, maxTicks);
+        }
+        if (saveFramePath != NULL){
+            passed = saveFrame(saveFramePath);
+        }
+        if (goldenPath != NULL){
+            passed = compareWithGolden(goldenPath) && passed;
+        }
+        stopNetplay();
+        stopCapture();
+        unloadSoftwareAssets();
+        stopSoftwareRenderer();
+        stopRecording();
+        stopProfileLog();
+        printWorkerStats();
+        stopWorkers();
+        return passed ? 0 : 1;
+    }
+    
+    // Initialization
+    //--------------------------------------------------------------------------------------
+    
+    const Color BACKGROUND_COLOR = {10, 0, 0};
+
+    if (targetFps < 0){
+        SetConfigFlags(FLAG_VSYNC_HINT);
+    }
+    InitWindow(windowWidth, windowHeight, "Educanet Blaster");
+    InitAudioDevice();
+    
+    SetTargetFPS(targetFps > 0 ? targetFps : 0);    // the simulation keeps its own rate, see TICK_RATE
+    ToggleFullscreen();
+    
+    if (!startLoadingAssets()){
+        CloseAudioDevice();
+        CloseWindow();
+        stopNetplay();
+        stopCapture();
+        stopSoftwareRenderer();
+        stopRecording();
+        stopProfileLog();
+        stopWorkers();
+        return 1;
+    }
+    startAudioThread();
+    
+    bool firstFrame = true;
+    while (!atomic_load(&assetsReady)){
+        BeginDrawing();
+            ClearBackground(BACKGROUND_COLOR);
+            drawLoadingScreen();
+        EndDrawing();
+        if (firstFrame){
+            printf("startup: loading screen up after %.1f ms\n", (getTimeSeconds() - launchTime) * 1000);
+            firstFrame = false;
+        }
+    }
+    finishLoadingAssets();
+    printf("startup: assets ready after %.1f ms, %.1f ms of that on the loader thread\n", (getTimeSeconds() - launchTime) * 1000, assetLoadTime * 1000);
+    firstFrame = true;
+    //--------------------------------------------------------------------------------------
+    Camera2D cam = {};
+    cam.zoom = screenZoom;
+    float scalingFactor = screenWidth /(float)(GetScreenWidth());
+    int renderTextureOffset = ((GetScreenWidth()) / 2) - (screenWidth / 2);
+    
+
+    // late input paces the loop itself instead of letting EndDrawing wait, see * Input latency *
+    double framePeriod = 0;
+    if (targetFps > 0){
+        framePeriod = 1.0 / targetFps;
+    }else if (targetFps < 0){
+        int refreshRate = GetMonitorRefreshRate(GetCurrentMonitor());
+        framePeriod = 1.0 / (refreshRate > 0 ? refreshRate : 60);
+    }
+    if (lateInput){
+        SetTargetFPS(0);
+    }
+
+    double previousTime = getTimeSeconds();
+    double previousPoll = previousTime;
+    double nextPresent = previousTime + framePeriod;
+    double accumulator = 0;
+    
+    // Main game loop
+    while (!WindowShouldClose())    // Detect window close button or ESC key
+    {
+        handleOverlayKeys();
+        if (lateInput && framePeriod > 0){
+            waitUntil(lateInputPollTime(nextPresent));
+            PollInputEvents();
+            // this poll moved every key's previous state along, a press EndDrawing saw was handled above
+            handleOverlayKeys();
+        }
+        profileFrameBegin();
+        qualityFrameBegin();
+        double now = getTimeSeconds();
+        double frameTime = now - previousTime;
+        previousTime = now;
+        recordFramePacing(frameTime);
+        accumulator += frameTime;
+        noteInputPoll(readInput(), (previousPoll + now) / 2);
+        previousPoll = now;
+        
+        // Update
+        //----------------------------------------------------------------------------------
+        // as many ticks as the time since the last frame covers, so a slow frame
+        // catches up instead of slowing the game down
+        int ticks = 0;
+        while (accumulator >= TICK_TIME){
+            if (ticks == MAX_TICKS_PER_FRAME){
+                pacingDroppedTicks += (long)(accumulator / TICK_TIME);
+                accumulator = fmod(accumulator, TICK_TIME);
+                break;
+            }
+            int input = polledInput;
+            if (netplaying){
+                // a stalled tick still uses up its time, waiting is how this side slows down
+                netplayTick(world, input);
+                noteInputSimulated();
+                accumulator -= TICK_TIME;
+                ticks++;
+                continue;
+            }
+            rememberWorldPositions(world);
+            // holding backspace plays the last few seconds backwards. not while recording,
+            // the recording would no longer line up with the game
+            if (recordingFile == NULL && IsKeyDown(KEY_BACKSPACE)){
+                rewindTicks(world, 1);
+            }else {
+                recordInput(input);
+                updateGame(world, input);
+                noteInputSimulated();
+                if (recordingFile == NULL){
+                    pushRewind(world);
+                }
+            }
+            accumulator -= TICK_TIME;
+            ticks++;
+        }
+        pacingTicks += ticks;
+        renderAlpha = accumulator / TICK_TIME;
+        //----------------------------------------------------------------------------------
+
+        // Draw
+        //----------------------------------------------------------------------------------
+        profileBegin(PROFILE_DRAW);
+        if (softwareRender){
+            renderSoftwareFrame(world);
+            UpdateTexture(softwareTexture, framebuffer);
+        }else {
+            refreshHud(world);
+            BeginTextureMode(renderTexture);
+                BeginMode2D(cam);
+                ClearBackground(BACKGROUND_COLOR);
+                drawGame(world);
+                flushDrawQueue();
+                
+                EndMode2D();
+            EndTextureMode();
+        }
+        profileEnd(PROFILE_DRAW);
+        profileBegin(PROFILE_UPSCALE);
+        BeginDrawing();
+            ClearBackground(BACKGROUND_COLOR);
+            
+            // render textures come out upside down, the software frame does not
+            Texture2D frame = softwareRender ? softwareTexture : renderTexture.texture;
+            Rectangle r = { 0, 0, (float)(frame.width), (float)(softwareRender ? frame.height : -frame.height) };
+            Rectangle r2 = { renderTextureOffset, 0, (float)(GetScreenWidth()) * scalingFactor, (float)(GetScreenHeight()) };
+            Vector2 v = {0, 0};
+            DrawTexturePro(
+                frame,
+                r,
+                r2,
+                v,
+                0,
+                WHITE);
+            if (showProfiler){
+                drawProfilerOverlay();
+            }
+            if (showDrawStats){
+                drawSoundStats();
+            }
+            if (showDrawStats && capturing){
+                drawCaptureStats();
+            }
+            if (showDrawStats && netplaying){
+                drawNetStats();
+            }
+            if (showDrawStats){
+                drawQualityStats();
+                drawLatencyStats();
+                drawAudioStats();
+            }
+            profileEnd(PROFILE_UPSCALE);
+        
+        qualityFrameEnd();
+        recordFrameWork(getTimeSeconds() - now);
+        profileBegin(PROFILE_PRESENT);
+        EndDrawing();
+        profileEnd(PROFILE_PRESENT);
+        double presented = getTimeSeconds();
+        noteFramePresented(presented);
+        // a vsynced swap returns on the vblank, a fixed rate keeps to its own schedule
+        nextPresent = targetFps < 0 || nextPresent + framePeriod < presented ? presented + framePeriod : nextPresent + framePeriod;
+        if (softwareRender){
+            captureFrame(framebuffer, false, ticks);
+        }else if (captureTargetCount > 0){
+            readBackCaptureTarget(ticks);
+        }
+        if (firstFrame){
+            printf("startup: first game frame after %.1f ms\n", (getTimeSeconds() - launchTime) * 1000);
+            firstFrame = false;
+        }
+        profileFrameEnd();
+        //----------------------------------------------------------------------------------
+    }
+
+    // De-Initialization
+    //--------------------------------------------------------------------------------------
+    if (netplaying){
+        printNetStats();
+    }
+    stopNetplay();
+    stopCapture();
+    unloadSprites();      // textures, the audio thread and the sounds, while there is still a context and a device
+    CloseAudioDevice();
+    CloseWindow();        // Close window and OpenGL context
+    //--------------------------------------------------------------------------------------
+    unloadSoftwareAssets();
+    stopSoftwareRenderer();
+    stopRecording();
+    stopProfileLog();
+    printWorkerStats();
+    stopWorkers();
+    printFramePacing();
+    printQualityStats();
+    printf("%-12s %8s %8s %8s %8s %8s\n", "input", "changes", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    printLatency(lateInput ? "late" : "early");
+    printf("sounds: %ld triggered, %ld merged, %ld stolen, %ld dropped\n", soundsTriggered, soundsMerged, atomic_load(&soundsStolen), atomic_load(&soundsDropped));
+    printAudioStats();
+    return 0;
+}